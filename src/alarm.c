@@ -0,0 +1,58 @@
+#include <avr/io.h>
+#include "rtc.h"
+#include "alarm.h"
+
+// アラーム表（時報は常時有効、ユーザーアラームは初期状態で無効）
+alarm_t alarm_tab[ALARM_NUM] = {
+	{0x00, 0x00, 1}, // 時報 00:00
+	{0x12, 0x00, 1}, // 時報 12:00
+};
+volatile uint8_t alarm_loaded = ALARM_NONE;
+
+// アラーム設定（時刻はBCD）、呼び出し後にalarm_loadで反映
+void alarm_set(uint8_t id, uint8_t hour, uint8_t min, uint8_t enabled) {
+	if (id >= ALARM_NUM) return;
+	alarm_tab[id].hour = hour;
+	alarm_tab[id].min = min;
+	alarm_tab[id].enabled = enabled;
+}
+
+// hour:minより後で最も近いアラームをRTCのアラームレジスタへ設定
+// BCDは大小関係が保たれるため (時<<8)|分 のまま比較する
+void alarm_load(uint8_t hour, uint8_t min) {
+	uint16_t now = ((uint16_t)hour << 8) | min;
+	uint8_t next = ALARM_NONE, first = ALARM_NONE;
+	uint16_t next_key = 0xFFFF, first_key = 0xFFFF;
+
+	for (uint8_t i = 0; i < ALARM_NUM; i++) {
+		if (!alarm_tab[i].enabled) continue;
+		uint16_t key = ((uint16_t)alarm_tab[i].hour << 8) | alarm_tab[i].min;
+		if (key > now && key < next_key) {
+			next_key = key;
+			next = i;
+		}
+		if (key < first_key) {
+			first_key = key;
+			first = i;
+		}
+	}
+	if (next == ALARM_NONE) next = first; // 当日分がなければ翌日の最初
+
+	alarm_loaded = next;
+	if (next == ALARM_NONE) {
+		rtc_write(RTC_MIN_AL, RTC_AE); // 全アラーム無効
+		rtc_write(RTC_HOUR_AL, RTC_AE);
+	} else {
+		rtc_write(RTC_MIN_AL, alarm_tab[next].min);
+		rtc_write(RTC_HOUR_AL, alarm_tab[next].hour);
+	}
+	rtc_write(RTC_DAY_AL, RTC_AE); // 日・曜日は比較しない
+	rtc_write(RTC_WDAY_AL, RTC_AE);
+	rtc_flush();
+}
+
+// アラーム発生後：AFをクリアし（/INTを解放）、次のアラームを設定
+void alarm_ack(uint8_t hour, uint8_t min) {
+	rtc_write(RTC_CTRL2, RTC_CTRL2_RUN);
+	alarm_load(hour, min);
+}
\ No newline at end of file
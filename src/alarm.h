@@ -0,0 +1,28 @@
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <stdint.h>
+
+// アラーム番号
+#define ALARM_CHIME_0   0 // 時報（0時）
+#define ALARM_CHIME_12  1 // 時報（12時）
+#define ALARM_USER      2 // ユーザーアラーム先頭
+#define ALARM_NUM       6 // 時報2 + ユーザー4
+#define ALARM_NONE      0xFF
+
+typedef struct {
+	uint8_t hour;     // 時（BCD）
+	uint8_t min;      // 分（BCD）
+	uint8_t enabled;  // 1:有効
+} alarm_t;
+
+extern alarm_t alarm_tab[ALARM_NUM];
+extern volatile uint8_t alarm_loaded; // RTCに設定中のアラーム番号
+
+extern void alarm_set(uint8_t id, uint8_t hour, uint8_t min, uint8_t enabled);
+extern void alarm_load(uint8_t hour, uint8_t min);
+extern void alarm_ack(uint8_t hour, uint8_t min);
+
+#define alarm_is_chime(id) ((id) < ALARM_USER)
+
+#endif
\ No newline at end of file
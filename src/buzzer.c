@@ -0,0 +1,96 @@
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "config.h"
+#include "timer.h"
+#include "hal.h"
+#include "buzzer.h"
+
+// 音程はTimer0のCTC＋OC0Aトグルで生成
+// Fout = F_CPU/(2*N*(1+OCR0A))、プリスケーラNはOCR0Aが8bitに収まる最小値を選ぶ
+#define BUZ_HALF(f, n) ((F_CPU + (n) * (f)) / (2UL * (n) * (f))) // 半周期カウント（四捨五入）
+#define BUZ_DIV(f) (BUZ_HALF(f, 1UL) <= 256 ? 1UL : BUZ_HALF(f, 8UL) <= 256 ? 8UL : \
+                    BUZ_HALF(f, 64UL) <= 256 ? 64UL : BUZ_HALF(f, 256UL) <= 256 ? 256UL : 1024UL)
+#define BUZ_CS(n) ((n) == 1 ? 1 : (n) == 8 ? 2 : (n) == 64 ? 3 : (n) == 256 ? 4 : 5)
+#define PITCH(f) { BUZ_HALF(f, BUZ_DIV(f)) - 1, BUZ_CS(BUZ_DIV(f)) }
+
+#define NOTE_MIN_HZ 1047UL // C6
+#define NOTE_MAX_HZ 4186UL // C8
+
+#if BUZ_HALF(NOTE_MIN_HZ, 1024UL) > 256
+#error "F_CPU too high for the lowest buzzer note"
+#endif
+#if BUZ_HALF(NOTE_MAX_HZ, 1UL) < 8
+#error "F_CPU too low for the highest buzzer note"
+#endif
+
+typedef struct {
+	uint8_t ocr; // OCR0A
+	uint8_t cs;  // TCCR0Bのクロック選択
+} buz_pitch_t;
+
+// 音程表（コンパイル時にF_CPUから計算）
+static const buz_pitch_t pitch_tab[NOTE_NUM] PROGMEM = {
+	{0, 0},                                                 // 休符
+	PITCH(1047UL), PITCH(1175UL), PITCH(1319UL), PITCH(1397UL), // C6 D6 E6 F6
+	PITCH(1568UL), PITCH(1760UL), PITCH(1976UL),             // G6 A6 B6
+	PITCH(2093UL), PITCH(2349UL), PITCH(2637UL), PITCH(2794UL), // C7 D7 E7 F7
+	PITCH(3136UL), PITCH(3520UL), PITCH(3951UL),             // G7 A7 B7
+	PITCH(4186UL),                                           // C8
+	PITCH(BUZZER_BEEP_HZ),                                   // ビープ
+};
+
+const buz_note_t mel_beep1[] PROGMEM = {
+	{NOTE_BEEP, 2}, {0, 0}
+};
+const buz_note_t mel_beep2[] PROGMEM = {
+	{NOTE_BEEP, 2}, {NOTE_REST, 6}, {NOTE_BEEP, 2}, {0, 0}
+};
+const buz_note_t mel_chime[] PROGMEM = {
+	{NOTE_BEEP, 2}, {NOTE_REST, 6}, {NOTE_BEEP, 2}, {0, 0}
+};
+const buz_note_t mel_alarm[] PROGMEM = {
+	{NOTE_C7, 10}, {NOTE_E7, 10}, {NOTE_G7, 10}, {NOTE_C8, 20}, {NOTE_REST, 30},
+	{NOTE_C7, 10}, {NOTE_E7, 10}, {NOTE_G7, 10}, {NOTE_C8, 20}, {NOTE_REST, 30},
+	{NOTE_C7, 10}, {NOTE_E7, 10}, {NOTE_G7, 10}, {NOTE_C8, 40}, {0, 0}
+};
+
+static void buzzer_next(void);
+static swtimer_t buzzer_tmr = SWTIMER(buzzer_next); // 音の切り替え
+static const buz_note_t *buz_pos;                   // 次に鳴らす音
+
+// 指定音程で発音開始
+static void buzzer_tone(uint8_t note) {
+	const buz_pitch_t *p = &pitch_tab[note];
+	hal_buzzer_tone(pgm_read_byte(&p->ocr), pgm_read_byte(&p->cs));
+}
+
+// 次の音へ（タイマー満了時、Timer1割込み内）
+static void buzzer_next(void) {
+	uint8_t note = pgm_read_byte(&buz_pos->note);
+	uint8_t len = pgm_read_byte(&buz_pos->len);
+	if (len == 0) {
+		buzzer_stop();
+		return;
+	}
+	buz_pos++;
+	if (note == NOTE_REST || note >= NOTE_NUM) {
+		buzzer_stop();
+	} else {
+		buzzer_tone(note);
+	}
+	timer_start(&buzzer_tmr, len * BUZ_UNIT_MS, 0);
+}
+
+// メロディ再生開始（再生中のメロディは打ち切る）
+void buzzer_play(const buz_note_t *mel) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		buz_pos = mel;
+		buzzer_next();
+	}
+}
+
+// ブザー停止
+void buzzer_stop(void) {
+	hal_buzzer_off();
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef BUZZER_H
+#define BUZZER_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// 音名（ブザーの共振周波数付近のC6からC8）
+enum {
+	NOTE_REST = 0,
+	NOTE_C6, NOTE_D6, NOTE_E6, NOTE_F6, NOTE_G6, NOTE_A6, NOTE_B6,
+	NOTE_C7, NOTE_D7, NOTE_E7, NOTE_F7, NOTE_G7, NOTE_A7, NOTE_B7,
+	NOTE_C8,
+	NOTE_BEEP, // BUZZER_BEEP_HZ（従来の4kHzビープ音）
+	NOTE_NUM
+};
+
+#define BUZ_UNIT_MS  10 // 音長の単位（ms）
+
+// メロディ1音（フラッシュに配置、len=0で終端）
+typedef struct {
+	uint8_t note; // 音名（NOTE_REST:休符）
+	uint8_t len;  // 音長（BUZ_UNIT_MS単位）
+} buz_note_t;
+
+// 定義済みメロディ
+extern const buz_note_t mel_beep1[] PROGMEM;  // 20ms 1回
+extern const buz_note_t mel_beep2[] PROGMEM;  // 20ms 2回
+extern const buz_note_t mel_chime[] PROGMEM;  // 時報
+extern const buz_note_t mel_alarm[] PROGMEM;  // ユーザーアラーム
+
+extern void buzzer_play(const buz_note_t *mel);
+extern void buzzer_stop(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "common.h"
+#include "clock.h"
+
+// 時刻のダブルバッファ＋シーケンス番号（書き込み側が最新をseqの偶奇で公開）
+// 読み出し側は割込みを禁止せず、読み出し中にseqが変わったら読み直す
+static bcdtime_t buf[2] = {
+	{0x36, 0x34, 0x12, 0x09, 0x06, 0x25}, // 12:34:36 2025.06.09
+};
+static volatile uint8_t seq;
+
+// 一貫した時刻を取得（割込み内・メインどちらからも可）
+void clock_get(bcdtime_t *t) {
+	uint8_t s;
+	do {
+		s = seq;
+		barrier();
+		*t = buf[s & 1];
+		barrier();
+	} while (s != seq);
+}
+
+// 時刻を公開（書き込み側同士は割込み禁止で直列化、数十サイクル）
+// 読み出し→変更→公開をメインから行う場合は全体をATOMIC_BLOCKで囲む
+void clock_put(const bcdtime_t *t) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		uint8_t s = seq + 1;
+		buf[s & 1] = *t;
+		barrier();
+		seq = s;
+	}
+}
+
+// BCDインクリメント（hiを超えたらloへ戻る）
+uint8_t bcd_inc(uint8_t v, uint8_t lo, uint8_t hi) {
+	if (v >= hi) return lo;
+	v++;
+	if ((v & 0x0F) == 0x0A) v += 6; // 一の位の桁上げ
+	return v;
+}
+
+// 月の日数（BCD、月はBCDの1～12）
+static const uint8_t month_days[12] = {
+	0x31, 0x28, 0x31, 0x30, 0x31, 0x30, 0x31, 0x31, 0x30, 0x31, 0x30, 0x31
+};
+
+// 月末日（BCD、2000～2099年のうるう年を考慮）
+uint8_t bcd_mdays(uint8_t m, uint8_t y) {
+	uint8_t i = (m < 0x10) ? m - 1 : m - 7; // BCD月→0～11
+	if (i > 11) return 0x31;
+	if (i == 1 && !((((y >> 4) << 1) + (y & 0x0F)) & 3)) return 0x29; // 年%4==0（10の位*10 ≡ 10の位*2 mod 4）
+	return month_days[i];
+}
+
+// 時刻を1秒進める（INT0の1Hzで呼ぶ、繰り上がりは年まで）
+void clock_tick(void) {
+	bcdtime_t t;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		clock_get(&t);
+		do {
+			t.sec = bcd_inc(t.sec, 0x00, 0x59);
+			if (t.sec) break;
+			t.min = bcd_inc(t.min, 0x00, 0x59);
+			if (t.min) break;
+			t.hour = bcd_inc(t.hour, 0x00, 0x23);
+			if (t.hour) break;
+			t.day = bcd_inc(t.day, 0x01, bcd_mdays(t.month, t.year));
+			if (t.day != 0x01) break;
+			t.month = bcd_inc(t.month, 0x01, 0x12);
+			if (t.month != 0x01) break;
+			t.year = bcd_inc(t.year, 0x00, 0x99);
+		} while (0);
+		clock_put(&t);
+	}
+}
\ No newline at end of file
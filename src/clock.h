@@ -0,0 +1,21 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+// 現在時刻（BCD）
+typedef struct {
+	uint8_t sec, min, hour;   // 時分秒
+	uint8_t day, month, year; // 年月日（年は下2桁）
+} bcdtime_t;
+
+#define clock_is_am(t) ((t)->hour < 0x12)
+
+extern void clock_get(bcdtime_t *t);
+extern void clock_put(const bcdtime_t *t);
+extern void clock_tick(void);
+
+extern uint8_t bcd_inc(uint8_t v, uint8_t lo, uint8_t hi);
+extern uint8_t bcd_mdays(uint8_t m, uint8_t y);
+
+#endif
\ No newline at end of file
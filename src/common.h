@@ -0,0 +1,13 @@
+#ifndef COMMON_H
+#define COMMON_H
+
+// 複数モジュールで使う小さなマクロ
+
+// コンパイラのメモリバリア（命令は生成しない）
+// 割込みとの受け渡しで、データの読み書きとインデックスの公開の順序を保つ
+#define barrier() __asm__ __volatile__ ("" ::: "memory")
+
+// 8bitのエラー・取りこぼしカウンタの加算（255で飽和）
+#define err_inc(c) do { if ((c) != 0xFF) (c)++; } while (0)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// タイミング設定：F_CPUと各周波数からプリスケーラと比較値をコンパイル時に決定
+// 実現できない組み合わせは#errorでビルドを止める
+
+#ifndef F_CPU
+#define F_CPU 1000000UL          // 動作クロック
+#endif
+
+#define TICK_HZ        1000UL    // Timer1システムティック（ソフトウェアタイマーは1ms単位）
+#define MUX_SLOT_HZ    1400UL    // 多重化スロット周波数（7スロットで200Hzリフレッシュ）
+#define BUZZER_BEEP_HZ 4000UL    // ビープ音の周波数
+
+// I2C SCL：RTC-8564の上限400kHz、F_CPUが足りなければ設定可能な最高速（F_CPU/16）
+#ifndef I2C_SCL_HZ
+#if F_CPU >= 16UL * 400000UL
+#define I2C_SCL_HZ     400000UL
+#else
+#define I2C_SCL_HZ     (F_CPU / 16UL)
+#endif
+#endif
+
+// USART0コンソール（uart.h、UART_CONSOLE=1で使用）：倍速モード（U2X0）で分周
+#ifndef UART_BAUD
+#define UART_BAUD      9600UL
+#endif
+#define UART_UBRR      ((F_CPU + 4UL * UART_BAUD) / (8UL * UART_BAUD) - 1)
+#define UART_ACTUAL    (F_CPU / (8UL * (UART_UBRR + 1)))
+
+// Timer1（16bit、CTC）：プリスケーラ 1/8/64/256/1024
+#define T1_COUNT(n) ((F_CPU + (n) * TICK_HZ / 2) / ((n) * TICK_HZ))
+#define T1_DIV (T1_COUNT(1UL) <= 65536UL ? 1UL : T1_COUNT(8UL) <= 65536UL ? 8UL : \
+                T1_COUNT(64UL) <= 65536UL ? 64UL : T1_COUNT(256UL) <= 65536UL ? 256UL : 1024UL)
+#define T1_CS  (T1_DIV == 1 ? 1 : T1_DIV == 8 ? 2 : T1_DIV == 64 ? 3 : T1_DIV == 256 ? 4 : 5)
+#define T1_OCR (T1_COUNT(T1_DIV) - 1)
+
+// Timer2（8bit、CTC）：プリスケーラ 1/8/32/64/128/256/1024
+// OCR2Aは254以下（OCR2B=255を「スロット内で消灯しない」に使う）
+#define T2_COUNT(n) ((F_CPU + (n) * MUX_SLOT_HZ / 2) / ((n) * MUX_SLOT_HZ))
+#define T2_DIV (T2_COUNT(1UL) <= 255UL ? 1UL : T2_COUNT(8UL) <= 255UL ? 8UL : \
+                T2_COUNT(32UL) <= 255UL ? 32UL : T2_COUNT(64UL) <= 255UL ? 64UL : \
+                T2_COUNT(128UL) <= 255UL ? 128UL : T2_COUNT(256UL) <= 255UL ? 256UL : 1024UL)
+#define T2_CS  (T2_DIV == 1 ? 1 : T2_DIV == 8 ? 2 : T2_DIV == 32 ? 3 : T2_DIV == 64 ? 4 : \
+                T2_DIV == 128 ? 5 : T2_DIV == 256 ? 6 : 7)
+#define T2_OCR (T2_COUNT(T2_DIV) - 1)
+
+// TWI：SCL = F_CPU/(16+2*TWBR*4^TWPS)、要求値を超えないよう切り上げ
+#define TWI_BR(p) ((F_CPU - 16UL * I2C_SCL_HZ + 2UL * (p) * I2C_SCL_HZ - 1) / (2UL * (p) * I2C_SCL_HZ))
+#define TWI_PS  (TWI_BR(1UL) <= 255 ? 1UL : TWI_BR(4UL) <= 255 ? 4UL : TWI_BR(16UL) <= 255 ? 16UL : 64UL)
+#define TWI_TWPS (TWI_PS == 1 ? 0 : TWI_PS == 4 ? 1 : TWI_PS == 16 ? 2 : 3)
+#define TWI_TWBR TWI_BR(TWI_PS)
+
+#if TICK_HZ != 1000
+#error "TICK_HZ must be 1000: software timers count in milliseconds"
+#endif
+#if T1_COUNT(1024UL) > 65536UL
+#error "Timer1 cannot reach TICK_HZ at this F_CPU"
+#endif
+#if T1_COUNT(1UL) < 250
+#error "F_CPU too low for a 1 ms tick"
+#endif
+#if T2_COUNT(1024UL) > 255UL
+#error "Timer2 cannot reach MUX_SLOT_HZ at this F_CPU"
+#endif
+#if T2_COUNT(1UL) < 16
+#error "MUX_SLOT_HZ too high for this F_CPU"
+#endif
+#if I2C_SCL_HZ > 400000UL
+#error "RTC-8564 supports I2C SCL up to 400 kHz"
+#endif
+#if F_CPU < 16UL * I2C_SCL_HZ
+#error "I2C_SCL_HZ too high for this F_CPU (maximum F_CPU/16)"
+#endif
+#if UART_UBRR > 4095
+#error "UART_BAUD too low for this F_CPU"
+#endif
+#if UART_ACTUAL * 50UL < UART_BAUD * 49UL || UART_ACTUAL * 50UL > UART_BAUD * 51UL
+#error "UART_BAUD not reachable within 2% at this F_CPU"
+#endif
+#if TWI_BR(64UL) > 255
+#error "I2C_SCL_HZ too low for this F_CPU"
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include <avr/io.h>
+#include "common.h"
+#include "event.h"
+
+// 単一生産者・単一消費者リング（ロックなし）
+// 生産者：割込み（AVRは多重割込みしないため全割込みで1つの生産者とみなせる）
+// 消費者：メインループ
+static uint8_t ring[EVQ_LEN];
+static volatile uint8_t head;  // 次の書き込み位置（生産者のみ更新）
+static volatile uint8_t tail;  // 次の読み出し位置（消費者のみ更新）
+volatile uint8_t event_lost;
+
+// イベント投入（割込み内から呼ぶ）
+void event_post(uint8_t ev) {
+	uint8_t h = head;
+	uint8_t next = (h + 1) & (EVQ_LEN - 1);
+	if (next == tail) {
+		err_inc(event_lost);
+		return;
+	}
+	ring[h] = ev;
+	barrier(); // データを書いてから公開
+	head = next;
+}
+
+// イベント取り出し（メインループから呼ぶ、なければEVT_NONE）
+uint8_t event_get(void) {
+	uint8_t t = tail;
+	if (t == head) return EVT_NONE;
+	uint8_t ev = ring[t];
+	barrier(); // 読み出してから解放
+	tail = (t + 1) & (EVQ_LEN - 1);
+	return ev;
+}
+
+// 未処理イベントがあるか
+uint8_t event_pending(void) {
+	return tail != head;
+}
\ No newline at end of file
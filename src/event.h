@@ -0,0 +1,27 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <stdint.h>
+
+// 割込み→メインループのイベント（上位4bit: 種別、下位4bit: 引数）
+#define EVT_NONE    0x00
+#define EVT_SEC     0x10 // INT0の1秒
+#define EVT_ALARM   0x20 // RTCアラーム（AF）検出
+#define EVT_INPUT   0x30 // スイッチ（引数: EV_xxx）
+#define EVT_TIMER   0x40 // ソフトウェアタイマー満了（引数: タイマー番号）
+#define EVT_RTC     0x50 // RTC読み出し完了
+#define EVT_REDRAW  0x60 // 表示状態の変化
+#define EVT_UART    0x70 // コンソール1行受信（行末ごと）
+
+#define evt_type(e) ((e) & 0xF0)
+#define evt_arg(e)  ((e) & 0x0F)
+
+#define EVQ_LEN     16 // キュー長（2のべき乗、最大15件待機）
+
+extern volatile uint8_t event_lost; // 満杯で捨てたイベント数（255で飽和）
+
+extern void event_post(uint8_t ev);
+extern uint8_t event_get(void);
+extern uint8_t event_pending(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+// ハードウェア抽象化層（AVR実装：hal_avr.c、割込み内で使う処理はここでインライン）
+// 別の実装（ホスト上のシミュレーター等）はこのヘッダーとhal_avr.cを差し替える
+// TWIはi2c.hの非同期転送API（i2c_submit）が境界
+
+extern void hal_init(void);        // ピン、省電力、タイマー、外部割込みの設定（割込み許可前）
+extern void hal_tick_start(void);  // 1msティック割込み開始
+extern void hal_mux_start(void);   // 多重化割込み開始（スロット開始と消灯の2つ）
+extern void hal_sw_init(void);     // スイッチのピン変化割込み開始
+extern void hal_idle(void);        // アイドルスリープ（割込み禁止で呼び、割込み許可で戻る）
+extern void hal_buzzer_tone(uint8_t ocr, uint8_t cs); // Timer0 CTC＋OC0Aトグルで発音
+extern void hal_buzzer_off(void);
+
+#define hal_irq_off()  cli()
+#define hal_irq_on()   sei()
+
+#define HAL_PORTC_IDLE ((1<<PC4)|(1<<PC5)) // PORTC消灯時の値（SDA/SCLプルアップのみ）
+
+// 多重化出力：全COM消灯→セグメント→COMの順にポートイメージ{PORTB, PORTC, PORTD}を出力
+// extraはPORTDに常時ORするビット（計測ピン用）
+static inline void hal_mux_out(const uint8_t *img, uint8_t extra) {
+	PORTD = extra; // COM0,1,4,5,6 low（PD6はTimer0のOC0Aが優先）
+	PORTC = HAL_PORTC_IDLE; // COM2,3 low
+	PORTB = img[0];
+	PORTC = img[1];
+	PORTD = img[2] | extra;
+}
+
+// 多重化消灯：全COMを消灯（スロット内の点灯時間終了）
+static inline void hal_mux_blank(uint8_t extra) {
+	PORTD = extra;
+	PORTC = HAL_PORTC_IDLE;
+}
+
+// スロット内の点灯時間（Timer2カウント、T2_OCRより大きければ比較Bが一致せず消灯しない：割込みは開始の1回のみ）
+// スロット開始の割込みで呼ぶ。前の値で立った比較一致を捨て、応答遅れで既に過ぎていれば直ちに消灯
+static inline void hal_mux_on_time(uint8_t on, uint8_t extra) {
+	OCR2B = on;
+	TIFR2 = (1 << OCF2B);
+	if (TCNT2 >= on) hal_mux_blank(extra);
+}
+
+// スイッチ入力（bit0:S1, bit1:S2、押下で1）
+static inline uint8_t hal_sw_read(void) {
+	return (~PINC >> PC2) & 0x03;
+}
+
+// RTCの/INTレベル（LOWで0）
+static inline uint8_t hal_int_level(void) {
+	return PIND & (1 << PD2);
+}
+
+#endif
\ No newline at end of file
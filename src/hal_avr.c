@@ -0,0 +1,79 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "config.h"
+#include "hal.h"
+
+// ピン・周辺機能の初期化（割込み許可前に呼ぶ）
+void hal_init(void) {
+	// ピン初期化
+	DDRB = 0xFF;
+	DDRC = 0x03; //0b0000 0011 PC4/PC5（SDA/SCL）は入力のまま（LOW出力にするとi2c_initがバスの保持と誤認する）
+	DDRD = 0xFB; //PD2入力 それ以外は出力 PD6はTimer0で制御 0b1111 1011
+	PORTC = 0;
+	PORTD = 0;
+
+	// 未使用ペリフェラル停止（ADC、SPI、USART0、アナログコンパレータ）
+	ACSR = (1<<ACD);
+	PRR = (1<<PRADC) | (1<<PRSPI) | (1<<PRUSART0);
+	// Timer1/Timer2は内部クロック同期動作のためパワーセーブでは停止する→アイドルのみ使用
+	set_sleep_mode(SLEEP_MODE_IDLE);
+
+	// Timer2: 多重化約1400Hz（リフレッシュ200Hz）
+	TCCR2A = (1<<WGM21);
+	TCCR2B = T2_CS;
+	OCR2A = T2_OCR; // 1MHz: 1000000/8/1400-1 = 88
+	OCR2B = 0xFF;   // 輝度最大（スロット内で消灯しない）
+
+	// Timer1: 1ms周期（TICK_HZ）
+	TCCR1A = 0;
+	TCCR1B = (1<<WGM12) | T1_CS; // CTCモード
+	OCR1A = T1_OCR; // 1MHz: 1000000/1/1000-1 = 999
+
+	// INT0: 立ち下がりで1Hz更新
+	EICRA = (1<<ISC01);
+	EIMSK = (1<<INT0);
+
+	// ブザー初期化（停止状態）
+	hal_buzzer_off();
+}
+
+void hal_tick_start(void) {
+	TIMSK1 = (1<<OCIE1A);
+}
+
+void hal_mux_start(void) {
+	TIMSK2 = (1<<OCIE2A) | (1<<OCIE2B);
+}
+
+// ピン変化割込み初期化（PC2=PCINT10, PC3=PCINT11）
+void hal_sw_init(void) {
+	PCMSK1 = (1<<PCINT10) | (1<<PCINT11);
+	PCIFR = (1<<PCIF1);
+	PCICR |= (1<<PCIE1);
+}
+
+// アイドルスリープ（割込み禁止で呼ぶ）
+void hal_idle(void) {
+	sleep_enable();
+	sei(); // sei直後の命令までは割込みが入らないためイベントを取りこぼさない
+	sleep_cpu();
+	sleep_disable();
+}
+
+// 発音開始
+void hal_buzzer_tone(uint8_t ocr, uint8_t cs) {
+	TCCR0B = 0;
+	TCNT0 = 0; // OCR0A変更時にTCNT0が超えて一周するのを防ぐ
+	OCR0A = ocr;
+	// CTCモード（WGM01 = 1）、Toggle OC0A on compare match（COM0A0 = 1）
+	TCCR0A = (1 << COM0A0) | (1 << WGM01);
+	TCCR0B = cs;
+}
+
+// 発音停止
+void hal_buzzer_off(void) {
+	TCCR0A = 0; // PWM無効
+	TCCR0B = 0; // クロック停止
+	PORTD &= ~(1<<PD6); // PD6をLOW
+}
\ No newline at end of file
@@ -1,42 +1,265 @@
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "config.h"
+#include <util/delay.h>
+#include "common.h"
 #include "i2c.h"
+#include "prof.h"
+
+#define TWI_CONT  ((1 << TWINT) | (1 << TWEN) | (1 << TWIE))
+#define TWI_ACK   (TWI_CONT | (1 << TWEA))
+#define TWI_START (TWI_CONT | (1 << TWSTA))
+
+static i2c_xfer_t *volatile queue[I2C_QUEUE_LEN]; // 転送キュー
+static volatile unsigned char q_head, q_tail;     // 投入位置, 実行中位置
+static volatile unsigned char locked;             // 同期API使用中
+static unsigned char idx;                          // 実行中転送のデータ位置
+static unsigned char retry;                        // 実行中転送の再試行回数
+static volatile unsigned char idle_ms;             // 最後のTWI割込みからの経過時間
+
+volatile i2c_err_t i2c_err;                        // エラー回数
+#if PROF_STATS
+static uint32_t xfer_t0;                           // 実行中転送の開始時刻
+#endif
+
+#define SDA (1 << PC4)
+#define SCL (1 << PC5)
+#define I2C_WAIT_LOOPS (F_CPU / 8000UL) // 同期APIの1回の待ち上限（1ループ8サイクル以下なので1ms以内）
+
+// バス復旧：スレーブがSDAを離すまでSCLを最大9回送り、STOPを出す
+// TWIを停止してからポートで直接駆動する（オープンドレイン動作、割込み禁止で呼ぶ）
+static void i2c_recover(void) {
+	TWCR = 0; // TWI停止（ピンをポート制御へ）
+	PORTC &= ~(SDA | SCL); // LOW出力はDDRで切り替え
+	DDRC &= ~(SDA | SCL);
+	for (unsigned char i = 0; i < 9 && !(PINC & SDA); i++) {
+		DDRC |= SCL;
+		_delay_us(5);
+		DDRC &= ~SCL;
+		_delay_us(5);
+	}
+	// STOP：SCL=L, SDA=L → SCL=H → SDA=H
+	DDRC |= SCL;
+	DDRC |= SDA;
+	_delay_us(5);
+	DDRC &= ~SCL;
+	_delay_us(5);
+	DDRC &= ~SDA;
+	_delay_us(5);
+	PORTC |= SDA | SCL; // プルアップ有効
+	err_inc(i2c_err.recover);
+}
 
 void i2c_init(void) {
-	DDRC &= ~((1 << PC4) | (1 << PC5)); // SDA/SCL̓[h
-	PORTC |= (1 << PC4) | (1 << PC5); // vAbvL
-	TWCR = 0x00; // TWIZbg
-	TWSR = 0x00; // 
-	TWBR = 0; // 56.7kHz(j
-	TWDR = 0x00; // TWDRNA
-	TWCR = (1 << TWEN); // TWIL
+	DDRC &= ~(SDA | SCL); // SDA/SCL入力モード
+	PORTC |= SDA | SCL; // プルアップ有効
+	if (!(PINC & SDA)) i2c_recover(); // リセット前の転送途中でSDAが保持されている
+	TWCR = 0x00; // TWIリセット
+	TWSR = TWI_TWPS; // プリスケーラ
+	TWBR = TWI_TWBR; // I2C_SCL_HZ（1MHz時はTWBR=0で62.5kHz、実測56.7kHz）
+	TWDR = 0x00; // TWDRクリア
+	TWCR = (1 << TWEN); // TWI有効
 }
 
-int i2c_start(unsigned char adr) {
+// START＋SLA送信（同期API、占有済みで呼ぶ）
+static int start_bus(unsigned char adr) {
     TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN); // START condition
-    i2c_wait(TWINT);
-    if ((i2c_status() != TW_START) && (i2c_status() != TW_REP_START)) return -1;
+    if (i2c_wait(TWINT) != 0) return -1;
+    if ((i2c_status() != TW_START) && (i2c_status() != TW_REP_START)) {
+        err_inc(i2c_err.bus);
+        return -1;
+    }
 
-    TWDR = adr; // SLA+R/W Zbg
-    TWCR = (1 << TWINT) | (1 << TWEN); // MJn
-    i2c_wait(TWINT);
-    if ((i2c_status() != TW_MT_SLA_ACK) && (i2c_status() != TW_MR_SLA_ACK)) return -1;
+    TWDR = adr; // SLA+R/W をセット
+    TWCR = (1 << TWINT) | (1 << TWEN); // 送信開始
+    if (i2c_wait(TWINT) != 0) return -1;
+    if ((i2c_status() != TW_MT_SLA_ACK) && (i2c_status() != TW_MR_SLA_ACK)) {
+        err_inc(i2c_err.nack);
+        return -1;
+    }
 
     return 0;
 }
 
+// 失敗時はSTOPを出して占有を解放する（呼び出し側はi2c_stopを呼ばずに戻ってよい）
+int i2c_start(unsigned char adr) {
+	// 非同期キューが空になるまで待ってからバスを占有（割込み内から呼ばないこと）
+	for (;;) {
+		unsigned char ok = 0;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			if (q_head == q_tail) {
+				locked = 1;
+				ok = 1;
+			}
+		}
+		if (ok) break;
+	}
+
+	if (start_bus(adr) != 0) {
+		i2c_stop(); // 占有中に投入された非同期転送もここで開始
+		return -1;
+	}
+	return 0;
+}
+
 void i2c_stop(void) {
-	TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		locked = 0;
+		if (q_head != q_tail) {
+			retry = 0;
+			idle_ms = 0;
+			PROF_START(xfer_t0);
+			TWCR = TWI_START | (1 << TWSTO); // STOP後に待機中の非同期転送を開始
+		} else {
+			TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+		}
+	}
 }
 
 int i2c_send(unsigned char data) {
 	TWDR = data;
 	TWCR = (1 << TWINT) | (1 << TWEN);
-	i2c_wait(TWINT);
-	return (i2c_status() == TW_MT_DATA_ACK) ? 0 : -1;
+	if (i2c_wait(TWINT) != 0) return -1;
+	if (i2c_status() != TW_MT_DATA_ACK) {
+		err_inc(i2c_err.nack);
+		return -1;
+	}
+	return 0;
 }
 
+// 戻り値: 受信データ（0～255）、タイムアウト時-1
 int i2c_recv(unsigned char ack) {
 	TWCR = (1 << TWINT) | (ack ? (1 << TWEA) : 0) | (1 << TWEN);
-	i2c_wait(TWINT);
+	if (i2c_wait(TWINT) != 0) return -1;
 	return TWDR;
+}
+
+// 同期APIのTWCRビット待ち（上限I2C_WAIT_LOOPS、タイムアウト時はバス復旧して-1）
+int i2c_wait_bit(unsigned char bit) {
+	for (unsigned int n = I2C_WAIT_LOOPS; n; n--) {
+		if (TWCR & (1 << bit)) return 0;
+	}
+	err_inc(i2c_err.timeout);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		i2c_recover();
+		TWCR = (1 << TWEN);
+	}
+	return -1;
+}
+
+// 非同期転送をキューに投入（割込み内からも可、ブロックしない）
+int i2c_submit(i2c_xfer_t *x) {
+	int ret = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		unsigned char next = (q_head + 1) & (I2C_QUEUE_LEN - 1);
+		if (x->status == I2C_BUSY || x->len == 0 || next == q_tail) {
+			ret = -1; // 投入済み、または満杯
+		} else {
+			x->status = I2C_BUSY;
+			queue[q_head] = x;
+			if (q_head == q_tail && !locked) {
+				retry = 0;
+				idle_ms = 0;
+				PROF_START(xfer_t0);
+				TWCR = TWI_START; // バス空きなら即開始
+			}
+			q_head = next;
+		}
+	}
+	return ret;
+}
+
+// 非同期キューが空か
+unsigned char i2c_idle(void) {
+	return q_head == q_tail;
+}
+
+// 実行中転送の完了処理と次の転送の開始
+static void i2c_finish(unsigned char status) {
+	i2c_xfer_t *x = queue[q_tail];
+
+	if (status != I2C_DONE && retry < I2C_RETRIES) {
+		retry++; // 同じ転送を最初からやり直す
+		TWCR = TWI_START | (1 << TWSTO);
+		return;
+	}
+	if (status != I2C_DONE) err_inc(i2c_err.fail);
+	PROF_END(PROF_I2C, xfer_t0);
+	retry = 0;
+	q_tail = (q_tail + 1) & (I2C_QUEUE_LEN - 1);
+	if (q_tail != q_head) {
+		PROF_START(xfer_t0);
+		TWCR = TWI_START | (1 << TWSTO); // STOP→START
+	} else {
+		TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN); // STOP、割込み停止
+	}
+	x->status = status;
+	if (x->cb) x->cb(x);
+}
+
+// TWI割込み：非同期転送ステートマシン
+ISR(TWI_vect) {
+	i2c_xfer_t *x = queue[q_tail];
+
+	idle_ms = 0;
+
+	switch (i2c_status()) {
+		case TW_START:
+			TWDR = x->adr & ~TW_READ; // SLA+W
+			TWCR = TWI_CONT;
+			break;
+		case TW_REP_START:
+			TWDR = x->adr | TW_READ; // SLA+R
+			TWCR = TWI_CONT;
+			break;
+		case TW_MT_SLA_ACK:
+			TWDR = x->reg; // レジスタアドレス
+			idx = 0;
+			TWCR = TWI_CONT;
+			break;
+		case TW_MT_DATA_ACK:
+			if (x->dir == I2C_READ) {
+				TWCR = TWI_START; // リピートスタートで読み出しへ
+			} else if (idx < x->len) {
+				TWDR = x->buf[idx++];
+				TWCR = TWI_CONT;
+			} else {
+				i2c_finish(I2C_DONE);
+			}
+			break;
+		case TW_MR_SLA_ACK:
+			TWCR = (x->len > 1) ? TWI_ACK : TWI_CONT; // 最終バイトはNACK
+			break;
+		case TW_MR_DATA_ACK:
+			x->buf[idx++] = TWDR;
+			TWCR = (idx + 1 < x->len) ? TWI_ACK : TWI_CONT;
+			break;
+		case TW_MR_DATA_NACK:
+			x->buf[idx] = TWDR;
+			i2c_finish(I2C_DONE);
+			break;
+		case TW_MT_SLA_NACK:
+		case TW_MT_DATA_NACK:
+		case TW_MR_SLA_NACK:
+			err_inc(i2c_err.nack);
+			i2c_finish(I2C_ERROR);
+			break;
+		default: // アービトレーション喪失、バスエラー
+			err_inc(i2c_err.bus);
+			i2c_finish(I2C_ERROR);
+			break;
+	}
+}
+
+// 非同期転送の監視（Timer1割込みから1msごとに呼ぶ）
+// TWI割込みがI2C_TIMEOUT_MS途絶えたらバスを復旧して再試行
+void i2c_tick(void) {
+	if (q_head == q_tail || locked) return;
+	if (++idle_ms < I2C_TIMEOUT_MS) return;
+	idle_ms = 0;
+	err_inc(i2c_err.timeout);
+	i2c_recover();
+	TWCR = (1 << TWEN);
+	i2c_finish(I2C_ERROR);
 }
\ No newline at end of file
@@ -3,13 +3,62 @@
 
 #include <util/twi.h>
 
-#define i2c_wait(p) loop_until_bit_is_set(TWCR, p)
+#define i2c_wait(p) i2c_wait_bit(p) // 従来の i2c_wait(TWINT) はそのまま使える（上限付き、戻り値0/-1）
 #define i2c_status() (TWSR & 0xf8)
 
+// 非同期転送の状態
+#define I2C_DONE    0
+#define I2C_BUSY    1
+#define I2C_ERROR   2
+
+// 非同期転送の方向
+#define I2C_WRITE   0
+#define I2C_READ    1
+
+#define I2C_QUEUE_LEN 8 // 転送キュー長（2のべき乗、最大7件待機）
+#define I2C_TIMEOUT_MS 10 // TWI割込みが途絶えてから打ち切るまでの時間
+#define I2C_RETRIES    2  // 失敗時の再試行回数
+
+// 最悪所要時間（バスが応答しない場合）
+//   非同期転送1件: (I2C_RETRIES+1)*(I2C_TIMEOUT_MS+1)ms + 復旧約0.1ms*3 ≒ 34ms
+//   キュー満杯（7件）の完了待ち: 約240ms
+//   同期API（i2c_start/send/recv）1回: 約1ms + 復旧約0.1ms
+// NACKやバスエラーは割込みで即時検出されるため、上記より短い
+
+// エラー回数（255で飽和）
+typedef struct {
+	unsigned char nack;     // NACK応答
+	unsigned char bus;      // アービトレーション喪失、バスエラー
+	unsigned char timeout;  // 応答なし（タイムアウト）
+	unsigned char recover;  // バス復旧（SCL 9クロック+STOP）実行
+	unsigned char fail;     // 再試行後も失敗した転送
+} i2c_err_t;
+
+extern volatile i2c_err_t i2c_err;
+
+// 非同期転送要求（完了までバッファと共に呼び出し側が保持する）
+typedef struct i2c_xfer {
+	unsigned char adr;      // スレーブアドレス（書き込み側、例: 0xA2）
+	unsigned char reg;      // 開始レジスタ
+	unsigned char dir;      // I2C_WRITE / I2C_READ
+	unsigned char len;      // データ長（1以上）
+	unsigned char *buf;     // データバッファ
+	void (*cb)(struct i2c_xfer *x); // 完了コールバック（TWI割込み内で呼ばれる、NULL可）
+	volatile unsigned char status; // I2C_DONE / I2C_BUSY / I2C_ERROR
+} i2c_xfer_t;
+
 extern void i2c_init(void);
+
+// 同期API：i2c_startが0を返したら最後に必ずi2c_stopを呼ぶ（失敗時はi2c_start内で解放済み）
+// 占有中は非同期転送を開始しない
 extern int i2c_start(unsigned char adr);
 extern void i2c_stop(void);
 extern int i2c_send(unsigned char data);
 extern int i2c_recv(unsigned char ack);
+extern int i2c_wait_bit(unsigned char bit);
+
+extern int i2c_submit(i2c_xfer_t *x);
+extern unsigned char i2c_idle(void);
+extern void i2c_tick(void);
 
 #endif
\ No newline at end of file
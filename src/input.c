@@ -0,0 +1,107 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "input.h"
+#include "timer.h"
+#include "hal.h"
+
+#define LONG_PRESS_MS      2000 // 長押し判定
+#define REPEAT_START_MS    600  // 自動リピート開始
+#define REPEAT_MS          100  // 自動リピート周期（10Hz）
+
+static uint8_t state;        // デバウンス後の押下状態（IN_S1/IN_S2）
+static uint8_t ct0 = 0xFF, ct1 = 0xFF; // 垂直カウンタ（ビット毎の2bitカウンタ、11でリセット状態）
+static uint8_t session;      // 今回の押下で押されたスイッチ（全解放でクリア）
+static uint8_t consumed;     // 長押し/同時押しで解放イベントを出さない
+static uint8_t locked;       // 全解放までイベントを出さない
+static uint8_t pending;      // タイマー由来の未通知イベント
+uint8_t input_active = 1; // サンプリング中（0: 変化待ち、ピン変化割込みで再開、割込み内のみ）
+
+static void hold_done(void);
+static void repeat_done(void);
+static swtimer_t hold_tmr = SWTIMER(hold_done);
+static swtimer_t repeat_tmr = SWTIMER(repeat_done);
+
+// 長押し満了
+static void hold_done(void) {
+	if (locked) return;
+	if (state == (IN_S1 | IN_S2)) pending |= EV_BIT(EV_COMBO_LONG);
+	else if (state == IN_S2) pending |= EV_BIT(EV_S2_LONG);
+	else return;
+	consumed = 1;
+}
+
+// 自動リピート
+static void repeat_done(void) {
+	if (!locked) pending |= EV_BIT(EV_S2_REPEAT);
+}
+
+// 1msサンプリング：4回連続で一致した変化のみ確定し、イベントをビットで返す
+uint8_t input_tick(void) {
+	uint8_t raw = hal_sw_read(); // 押下で1
+	uint8_t chg = state ^ raw;
+	uint8_t ev;
+
+	// 垂直カウンタ：変化が続いたビットだけ4回目で反転
+	ct0 = ~(ct0 & chg);
+	ct1 = ct0 ^ (ct1 & chg);
+	chg &= ct0 & ct1;
+
+	if (chg) {
+		uint8_t released = state & chg;
+		state ^= chg;
+		session |= state;
+
+		// 状態が変わるたびに長押し判定をやり直す
+		if (state) timer_start(&hold_tmr, LONG_PRESS_MS, 0);
+		else timer_stop(&hold_tmr);
+		if (state == IN_S2) {
+			if (!timer_active(&repeat_tmr)) timer_start(&repeat_tmr, REPEAT_START_MS, REPEAT_MS);
+		} else {
+			timer_stop(&repeat_tmr);
+		}
+
+		// 単独押しの解放（同時押しや長押しを経た場合は出さない）
+		if (!locked && !consumed && session != (IN_S1 | IN_S2)) {
+			if (released & IN_S1) pending |= EV_BIT(EV_S1_SHORT);
+			if (released & IN_S2) pending |= EV_BIT(EV_S2_SHORT);
+		}
+		if (!state) {
+			session = 0;
+			consumed = 0;
+			locked = 0;
+		}
+	}
+
+	ev = pending;
+	pending = 0;
+
+	// 全解放で安定したらサンプリング停止（次の変化はPCINT1で検出）
+	if (!state && !raw && ct0 == 0xFF && ct1 == 0xFF) input_active = 0;
+	return ev;
+}
+
+// S1/S2のピン変化割込み：サンプリング再開
+ISR(PCINT1_vect) {
+	input_active = 1;
+}
+
+// ピン変化割込み初期化
+void input_init(void) {
+	hal_sw_init();
+}
+
+// デバウンス後の押下状態
+uint8_t input_held(void) {
+	return state;
+}
+
+// 全スイッチが離されるまでイベントを止める（モード遷移直後の解放を無視）
+void input_lock(void) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { // メインループから呼ばれる
+		if (!state) return;
+		locked = 1;
+		pending = 0;
+		timer_stop(&repeat_tmr);
+	}
+}
\ No newline at end of file
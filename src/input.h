@@ -0,0 +1,27 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+
+// スイッチビット（デバウンス後の状態）
+#define IN_S1        (1<<0) // S1 (PC2)
+#define IN_S2        (1<<1) // S2 (PC3)
+
+// 入力イベント番号（遷移テーブルの列）
+#define EV_S1_SHORT   0 // S1単独押し→解放
+#define EV_S2_SHORT   1 // S2単独押し→解放
+#define EV_S2_LONG    2 // S2を2秒押し続けた
+#define EV_COMBO_LONG 3 // S1+S2を2秒押し続けた
+#define EV_S2_REPEAT  4 // S2長押しの自動リピート（0.6秒後から10Hz）
+#define EV_NUM        5
+
+#define EV_BIT(ev)   (1<<(ev))
+
+extern uint8_t input_active;
+
+extern void input_init(void);
+extern uint8_t input_tick(void);
+extern uint8_t input_held(void);
+extern void input_lock(void);
+
+#endif
\ No newline at end of file
@@ -1,623 +1,1177 @@
 // ATmega88P 7seg LED Clock
-#define F_CPU 1000000UL
+#include "config.h"
 
 #include <avr/io.h>
-#include <util/delay.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
 #include "i2c.h"
+#include "rtc.h"
+#include "timer.h"
+#include "clock.h"
+#include "input.h"
+#include "alarm.h"
+#include "buzzer.h"
+#include "event.h"
+#include "prof.h"
+#include "hal.h"
+#include "uart.h"
+#include "settings.h"
+#include "stopwatch.h"
 
 #define MODE_NORMAL     0
 #define MODE_SET_HOUR   1
 #define MODE_SET_MIN    2
 #define MODE_SET_SEC    3
 #define MODE_SAVE       4
-#define MODE_DATE_DISP  5 // N\
-#define MODE_SET_YEAR   6 // Nݒ
-#define MODE_SET_MONTH  7 // ݒ
-#define MODE_SET_DAY    8 // ݒ
-
-// O[oϐ
-volatile uint8_t seg[8];         // 7ZO{COM\f[^
-volatile uint8_t mx = 0;         // dXbg
-volatile uint8_t hour = 12, min = 34, sec = 36;
-volatile uint8_t year = 25, month = 6, day = 9; // NiBCD`̉2j
-volatile uint8_t mode = MODE_NORMAL;
-volatile uint16_t switch_press_time = 0;
-volatile uint8_t is_am = 1;      // AM/PMtO
-volatile uint8_t is_24hour = 1;  // 24ԕ\LtOi1:24, 0:12ԁj
-volatile uint8_t rtc_update_flag; // INT0݃tO
-volatile uint8_t colon_blink_state = 0; // R̓_ŏԁi0:, 1:_j
-volatile uint16_t colon_timer = 0;      // R_ԃJE^
-volatile uint8_t led8_state = 0;        // LED8 (segDP) ̏ԁi0:, 1:_j
-volatile uint16_t led8_timer = 0;       // LED8_ԃJE^
-volatile uint8_t waiting_for_release = 0; // XCb`ҋ@tO
-volatile uint16_t switch2_hold_time = 0; // S2ԃJE^
-volatile uint8_t blink_enabled = 1;      // _ŗLtO
-volatile uint16_t led7_timer = 0;        // LED7_ԃJE^
-volatile uint16_t buzzer_timer = 0;      // uU[^C}[i100ms?0j
-volatile uint16_t date_display_timer = 0; // N\2b^C}[
-volatile uint8_t switch2_pressed = 0;     // S2ԁiN[hpj
-volatile uint8_t last_mode = MODE_NORMAL; // Õ[hiۑpj
-volatile uint8_t led7_always_on = 0;     // LED7펞_tO
-
-// 萔`
+#define MODE_DATE_DISP  5 // 年月日表示
+#define MODE_SET_YEAR   6 // 年設定
+#define MODE_SET_MONTH  7 // 月設定
+#define MODE_SET_DAY    8 // 日設定
+#define MODE_STOPWATCH  9 // ストップウォッチ
+#define MODE_COUNTDOWN  10 // カウントダウン
+#define MODE_NUM        11
+
+// グローバル変数
+uint8_t seg[8];                  // 7セグ＋COM表示データ（メインループのみ）
+uint8_t mux_img[7][4];           // 多重化スロット毎のポートイメージ {PORTB, PORTC, PORTD, 点灯時間}
+uint8_t mode = MODE_NORMAL;      // 表示・設定モード（メインループのみ）
+
+// 状態フラグ（GPIOR0：sbi/cbi/sbisで1命令アクセス）
+// メインからは単一ビットの定数でのみ書き換える（cbi/sbiになり割込みと競合しない）
+#define FLAGS       GPIOR0
+#define F_REDRAW    (1<<0) // 再描画イベント投入済み
+#define F_RESYNC    (1<<1) // RTC再同期要求
+#define F_ALARM     (1<<2) // アラーム発生（AFクリアと次のアラーム設定待ち）
+#define F_COLON     (1<<3) // コロン点灯中
+#define F_LED8      (1<<4) // LED8 (segDP) 点灯中
+#define F_BLINK_EN  (1<<5) // 点滅有効
+#define F_BLINK     (1<<6) // 点滅位相（0:消灯）
+#define F_IDLE      (1<<7) // メインループがスリープ中
+
+// 設定フラグ（GPIOR1：sbi/cbi不可のためメインループからのみ書き換える）
+#define CONF        GPIOR1
+#define C_24H       (1<<0) // 24時間表記（0:12時間）
+#define C_LED7_ON   (1<<1) // LED7常時点灯（VL検出から時刻再設定まで）
+
+// 起床率計測（1で有効、awake_permilleに直近1秒のメインループ起床率を‰で格納）
+#ifndef SLEEP_STATS
+#define SLEEP_STATS        0
+#endif
+#if SLEEP_STATS
+volatile uint16_t awake_permille;        // 直近1秒の起床率（‰、Timer1で標本化）
+#endif
+
+// 定数定義
 #define BLINK_CYCLES       250  // 0.25s (4Hz)
 #define COLON_CYCLES       500  // 0.5s
 #define LED8_CYCLES        50   // 16ms
-#define BUZZER_CYCLES      100  // 100ms
-#define BUZZER_ON1_START   100  // 0-10ms
-#define BUZZER_OFF1        80   // 10-90ms
-#define BUZZER_ON2         20   // 90-100ms
-#define BUZZER_OFF2        1    // 100ms-
+#define LED7_MS            2000 // 12時間表示切替時のLED7点灯時間
+#define INT_CHECK_MS       40   // /INT立ち下がりからアラーム判定までの時間（タイマーパルス幅約15.6msより長く）
 #define COLON_MASK         0x1E // segC,D,E,F (1<<1)|(1<<2)|(1<<3)|(1<<4)
 #define AM_MASK            (1<<6) // segA
 #define PM_MASK            (1<<7) // segB
 #define LED8_MASK          (1<<5) // segDP
 #define LED7_MASK          (1<<0) // segG
-#define DATE_DISP_TIME     2000 // N\ԁi2bj
-
-// _Ŕ͈̓e[uiJnmx, Imxj
-static const uint8_t blink_range[9][2] = {
-	{0, 6}, // MODE_NORMAL: S\
-	{4, 6}, // MODE_SET_HOUR: imx=4,5j
-	{2, 4}, // MODE_SET_MIN: imx=2,3j
-	{0, 2}, // MODE_SET_SEC: bimx=0,1j
-	{0, 6}, // MODE_SAVE: S\
-	{0, 6}, // MODE_DATE_DISP: S\i_łȂj
-	{4, 6}, // MODE_SET_YEAR: Nimx=4,5j
-	{2, 4}, // MODE_SET_MONTH: imx=2,3j
-	{0, 2}  // MODE_SET_DAY: imx=0,1j
+#define DATE_DISP_TIME     2000 // 年月日表示時間（2秒）
+#define RTC_RESYNC_SEC     60   // RTC再同期間隔（秒、1で毎秒RTCを読む）
+#define TMR_DATE_DISP      0    // EVT_TIMERの引数：年月日表示の自動復帰
+#define TMR_SYNC           1    // EVT_TIMERの引数：時刻合わせのRTC停止解除
+#define TMR_SAVE           2    // EVT_TIMERの引数：設定のEEPROM保存
+#define SAVE_DELAY_MS      10000 // 設定変更から保存までの時間（続けて変更すると延長し1回にまとめる）
+#define SAVE_RETRY_MS      100  // EEPROM書き込み中だった場合の再試行間隔
+
+static uint16_t resync_timer;    // 前回の再同期からの秒数
+static volatile uint8_t sec_seq; // INT0の回数（再同期の読み出し中に秒が進んだかの判定）
+static uint8_t sync_seq;         // 再同期の読み出しを要求したときのsec_seq
+
+// 多重化スロット毎のCOMピン（PORTC, PORTD）
+#if UART_CONSOLE
+#define COM0_PD            0 // PD0/PD1はUSART0が使用（秒の2桁は消灯）
+#define COM1_PD            0
+#else
+#define COM0_PD            (1<<PD0)
+#define COM1_PD            (1<<PD1)
+#endif
+static const uint8_t mux_com[7][2] = {
+	{0,         COM0_PD }, // COM0: 秒一の位
+	{0,         COM1_PD }, // COM1: 秒十の位
+	{(1<<PC0),  0       }, // COM2: 分一の位
+	{(1<<PC1),  0       }, // COM3: 分十の位
+	{0,         (1<<PD4)}, // COM4: 時一の位
+	{0,         (1<<PD5)}, // COM5: 時十の位
+	{0,         (1<<PD7)}  // COM6: コロン・AM/PM・LED7/8
+};
+
+// 輝度：スロット内の点灯時間をTimer2の比較Bで打ち切る（割込みはスロット毎に開始と消灯の2回、最大輝度は消灯しないので開始の1回）
+// レベル0?7の点灯率は約1.4倍刻みで 9, 13, 18, 25, 36, 50, 71, 100%（スロットの1/7に対して）
+#define BRIGHT_MAX         7
+#define MUX_ON(f)          ((uint8_t)(((T2_OCR + 1) * (f) + 128) / 256)) // 点灯率f/256のカウント
+static const uint8_t mux_on[BRIGHT_MAX + 1] = {
+	MUX_ON(23), MUX_ON(32), MUX_ON(45), MUX_ON(64), MUX_ON(91), MUX_ON(128), MUX_ON(181), 0xFF
+};
+static uint8_t dim_set;          // 減光段数（下位4bit:昼、上位4bit:夜、0で最大輝度）
+static uint8_t night[2];         // 夜間の時間帯 {開始時, 終了時}（BCD）
+static uint16_t dim_trim;        // 桁ごとの減光（2bit×7スロット）
+static uint8_t dim_now;          // 現在の減光段数（0xFFで全スロット再描画）
+
+// 表示ビュー
+#define VIEW_CLOCK         0 // 時刻表示（12/24時間設定に従う）
+#define VIEW_TIME24        1 // 時刻表示（設定中は常に24時間）
+#define VIEW_DATE          2 // 年月日表示
+#define VIEW_SW            3 // ストップウォッチ・カウントダウン（MM:SS.cc）
+#define NO_FIELD           0xFF
+
+// 表示フィールド属性
+#define ATTR_BLANK         (1<<0) // 消灯（点滅）
+#define ATTR_DOT           (1<<1) // 一の位のドット点灯
+#define ATTR_ZS            (1<<2) // 十の位ゼロサプレス
+
+// モード別表示テーブル（表示ビュー, 点滅フィールド 0:mx=0,1 1:mx=2,3 2:mx=4,5）
+static const uint8_t mode_disp[MODE_NUM][2] = {
+	{VIEW_CLOCK,  NO_FIELD}, // MODE_NORMAL: 全桁表示
+	{VIEW_TIME24, 2},        // MODE_SET_HOUR: 時（mx=4,5）
+	{VIEW_TIME24, 1},        // MODE_SET_MIN: 分（mx=2,3）
+	{VIEW_TIME24, 0},        // MODE_SET_SEC: 秒（mx=0,1）
+	{VIEW_CLOCK,  NO_FIELD}, // MODE_SAVE: 全桁表示
+	{VIEW_DATE,   NO_FIELD}, // MODE_DATE_DISP: 全桁表示（点滅なし）
+	{VIEW_DATE,   2},        // MODE_SET_YEAR: 年（mx=4,5）
+	{VIEW_DATE,   1},        // MODE_SET_MONTH: 月（mx=2,3）
+	{VIEW_DATE,   0},        // MODE_SET_DAY: 日（mx=0,1）
+	{VIEW_SW,     NO_FIELD}, // MODE_STOPWATCH: 分・秒・1/100秒
+	{VIEW_SW,     NO_FIELD}  // MODE_COUNTDOWN: 残り時間
 };
 
-// ֐vg^Cv
+// 関数プロトタイプ
 uint8_t mask(uint8_t num);
-uint8_t dec2bcd(uint8_t v);
-uint8_t bcd2dec(uint8_t v);
+uint8_t bcd_to12(uint8_t h);
+void set_value_inc(void);
 void rtc_init_full(void);
-void rtc_read_time(volatile uint8_t *h, volatile uint8_t *m, volatile uint8_t *s);
-void rtc_read_date(volatile uint8_t *y, volatile uint8_t *m, volatile uint8_t *d);
+void rtc_load_time(void);
+void rtc_load_date(void);
 void rtc_write_date(uint8_t y, uint8_t m, uint8_t d);
-void process_rtc_update(void);
+int process_rtc_update(void);
+void rtc_update_done(void);
 void read_switches(void);
+void input_action(uint8_t act);
 void set_rtc_time(uint8_t h, uint8_t m, uint8_t s);
-void buzzer_start(void);
-void buzzer_stop(void);
+void mux_render(uint8_t i);
+void render_update(void);
+static void dispatch(uint8_t ev);
+#if UART_CONSOLE
+static void console_line(void);
+static void console_sec(void);
+static void sync_release(void);
+#endif
+
+// ソフトウェアタイマー
+static void blink_done(void);
+static void colon_done(void);
+static void led8_done(void);
+static void led7_done(void);
+static void date_disp_done(void);
+static void int_check_done(void);
+static void save_done(void);
+static swtimer_t blink_tmr = SWTIMER(blink_done);         // 設定桁の点滅（4Hz）
+static swtimer_t colon_tmr = SWTIMER(colon_done);         // コロン点灯
+static swtimer_t led8_tmr = SWTIMER(led8_done);           // LED8点灯
+static swtimer_t led7_tmr = SWTIMER(led7_done);           // LED7点灯（動作中のみ点灯）
+static swtimer_t date_disp_tmr = SWTIMER(date_disp_done); // 年月日表示の自動復帰
+static swtimer_t int_check_tmr = SWTIMER(int_check_done); // /INTレベル判定（アラーム検出）
+static swtimer_t save_tmr = SWTIMER(save_done);           // 設定保存の遅延
+
+// 7セグメントフォント（BCDニブルで引く、10?15は「-」相当）
+static const uint8_t seg_font[16] = {
+	0x21, 0x77, 0x2A, 0x26, 0x74, 0xA4, 0xA0, 0x35, // 0-7
+	0x20, 0x24, 0xEF, 0xEF, 0xEF, 0xEF, 0xEF, 0xEF  // 8-9, 無効
+};
+#define SEG_BLANK          0xFF // 全セグメント消灯
+#define SEG_DASH           0xFE // 「-」（segGのみ）
 
-// 7ZOg}XN
+// 7セグメントマスク（BCDニブル→セグメント）
 uint8_t mask(uint8_t num) {
-	switch (num) {
-		case 0:  return 0x21;
-		case 1:  return 0x77;
-		case 2:  return 0x2A;
-		case 3:  return 0x26;
-		case 4:  return 0x74;
-		case 5:  return 0xA4;
-		case 6:  return 0xA0;
-		case 7:  return 0x35;
-		case 8:  return 0x20;
-		case 9:  return 0x24;
-		case 99: return 0xFF;
-		default: return 0xEF;
-	}
-}
-
-// 10iBCD
-uint8_t dec2bcd(uint8_t v) { return ((v/10)<<4)|(v%10); }
-// BCD10i
-uint8_t bcd2dec(uint8_t v) { return ((v>>4)*10)+(v&0x0F); }
-
-// RTC-8564 
-void rtc_init_full(void) {
-	// RTC~ (STOP=1)
-	i2c_start(0xA2);
-	i2c_send(0x00);
-	i2c_send(0x20); // STOP=1
-	i2c_stop();
-
-	// Control2: tONAEL
-	i2c_start(0xA2);
-	i2c_send(0x01);
-	i2c_send(0x11); // AIE=1, TIE=1
-	i2c_stop();
-
-	// CLKOUT Frequency
-	i2c_start(0xA2);
-	i2c_send(0x0D);
-	i2c_send(0x83); //FE=1,1Hz
-	i2c_stop();
-
-	// Timer Clock (1Hz)
-	i2c_start(0xA2);
-	i2c_send(0x0E);
-	i2c_send(0x82); // TE=1, 1Hz
-	i2c_stop();
-
-	// Timer Value = 1
-	i2c_start(0xA2);
-	i2c_send(0x0F);
-	i2c_send(0x01);
-	i2c_stop();
-	
-	// RTCăX^[g (STOP=0, TI/TP=1)
-	i2c_start(0xA2);
-	i2c_send(0x00);
-	i2c_send(0x10); // STOP=0, TI/TP=1
-	i2c_stop();
+	return seg_font[num & 0x0F];
 }
 
-// RTCǂݎ
-void rtc_read_time(volatile uint8_t *h, volatile uint8_t *m, volatile uint8_t *s) {
-	i2c_start(0xA2);
-	i2c_send(0x02);
-	i2c_stop();
+// 2桁の2進→BCD（0?99）
+static uint8_t bin_bcd(uint8_t v) {
+	return ((v / 10) << 4) | (v % 10);
+}
+
+// 24時間→12時間（BCD、13?23時を1?11時に）
+uint8_t bcd_to12(uint8_t h) {
+	if (h <= 0x12) return h;
+	h -= 0x12;
+	if ((h & 0x0F) > 9) h -= 6; // 一の位の桁借り
+	return h;
+}
+
+// RTC-8564 初期化（シャドウ経由、3バーストで書き込み）
+void rtc_init_full(void) {
+	// RTC停止 (STOP=1)、Control2: フラグクリア・割込有効
+	rtc_write(RTC_CTRL1, 0x20); // STOP=1
+	rtc_write(RTC_CTRL2, RTC_CTRL2_RUN); // TI/TP=1, AIE=1, TIE=1
+	rtc_flush();
+
+	// CLKOUT Frequency、Timer Clock (1Hz)、Timer Value = 1
+	rtc_write(RTC_CLKOUT, 0x83); // FE=1,1Hz
+	rtc_write(RTC_TCTRL, 0x82); // TE=1, 1Hz
+	rtc_write(RTC_TIMER, 0x01);
+	rtc_flush();
 
-	i2c_start(0xA3);
-	*s = bcd2dec(i2c_recv(1) & 0x7F); // b0x7FŃ}XNVLrbg
-	*m = bcd2dec(i2c_recv(1) & 0x7F); // 0x7FŃ}XN
-	*h = bcd2dec(i2c_recv(0) & 0x3F); // 0x3FŃ}XN
-	i2c_stop();
+	// RTC再スタート (STOP=0, TI/TP=1)：先の書き込み完了後に送られる
+	rtc_write(RTC_CTRL1, 0x10); // STOP=0, TI/TP=1
+	rtc_flush();
 }
 
-// RTCNǂݎ
-void rtc_read_date(volatile uint8_t *y, volatile uint8_t *m, volatile uint8_t *d) {
-	i2c_start(0xA2);
-	i2c_send(0x05); // dayWX^Jn
-	i2c_stop();
+// シャドウから時刻を取り込み（起動時と再同期の読み出し完了時のみ、シャドウは読み出し時点の値）
+void rtc_load_time(void) {
+	bcdtime_t t;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { // 他の書き込みと混ざらないよう読み出し→公開を一体で
+		clock_get(&t);
+		t.sec = rtc_reg[RTC_SEC] & 0x7F; // 秒を0x7FでマスクしてVLビット除去（BCDのまま）
+		t.min = rtc_reg[RTC_MIN] & 0x7F; // 分を0x7Fでマスク
+		t.hour = rtc_reg[RTC_HOUR] & 0x3F; // 時を0x3Fでマスク
+		clock_put(&t);
+	}
+}
 
-	i2c_start(0xA3);
-	*d = bcd2dec(i2c_recv(1) & 0x3F); // day (}XN: 0x3F)
-	i2c_recv(1); // weekday (XLbv)
-	*m = bcd2dec(i2c_recv(1) & 0x1F); // months (}XN: 0x1F)
-	*y = bcd2dec(i2c_recv(0)); // years
-	i2c_stop();
+// シャドウから年月日を取り込み
+void rtc_load_date(void) {
+	bcdtime_t t;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		clock_get(&t);
+		t.day = rtc_reg[RTC_DAY] & 0x3F; // day (マスク: 0x3F)
+		t.month = rtc_reg[RTC_MONTH] & 0x1F; // months (マスク: 0x1F)
+		t.year = rtc_reg[RTC_YEAR]; // years
+		clock_put(&t);
+	}
 }
 
-// RTCN
+// RTC年月日書き込み（1バースト、ブロックしない）
 void rtc_write_date(uint8_t y, uint8_t m, uint8_t d) {
-	if (y > 99) y = 0; // ͈͕␳
-	if (m > 12) m = 1;
-	if (d > 31) d = 1;
-	i2c_start(0xA2);
-	i2c_send(0x05); // dayWX^Jn
-	i2c_send(dec2bcd(d)); // day
-	i2c_send(0x00); // weekday (gp)
-	i2c_send(dec2bcd(m)); // months (century=0)
-	i2c_send(dec2bcd(y)); // years
-	i2c_stop();
-}
-
-// RTC-85640DWX^ǂݏo֐
-uint8_t rtc_read_reg0D(void) {
-	i2c_start(0xA2); // RTC݃AhX
-	i2c_send(0x0D); // 0DWX^w
-	i2c_stop();
-	
-	i2c_start(0xA3); // RTCǂݏoAhX
-	uint8_t data = i2c_recv(0); // 0DWX^ǂݏo
-	i2c_stop();
-	
-	return data;
+	if (y > 0x99) y = 0; // 範囲補正（BCD）
+	if (m > 0x12 || m == 0) m = 1;
+	if (d > 0x31 || d == 0) d = 1;
+	rtc_write(RTC_DAY, d); // day
+	rtc_write(RTC_WDAY, 0x00); // weekday (未使用)
+	rtc_write(RTC_MONTH, m); // months (century=0)
+	rtc_write(RTC_YEAR, y); // years
+	rtc_flush();
 }
 
-// INT0荞݁FtOZbgARLED8_JnAuU[Jn
+// INT0割り込み：1秒イベント、コロン＆LED8点灯開始、アラーム判定開始
 ISR(INT0_vect) {
-	rtc_update_flag = 1;
-	colon_blink_state = 1; // R_Jn
-	colon_timer = 0;
-	led8_state = 1;       // LED8_Jn
-	led8_timer = 0;
-	//buzzer_timer = 20; //b炷ݒ
-	
-	// 0i00:00:00j܂12i12:00:00jŃuU[Jn
-	if ((hour == 23 || hour == 11) && min == 59 && sec == 59) {
-		buzzer_timer = 100; // uU[100msi10ms+80ms+10msj
-	}
+	PROF_ENTER();
+	event_post(EVT_SEC);
+	sec_seq++;
+	sw_int0();
+	FLAGS |= F_COLON; // コロン点灯開始
+	timer_start(&colon_tmr, COLON_CYCLES, 0);
+	FLAGS |= F_LED8;  // LED8点灯開始
+	timer_start(&led8_tmr, LED8_CYCLES, 0);
+	timer_start(&int_check_tmr, INT_CHECK_MS, 0);
+	//buzzer_play(mel_beep1); //毎秒鳴らす設定
+	PROF_EXIT(PROF_INT0);
 }
 
-// RTCXV
-void process_rtc_update(void) {
-	rtc_read_time(&hour, &min, &sec);
-	is_am = (hour < 12);
+// /INTレベル判定：タイマーパルス終了後もLOWならRTCのアラーム（AF）が発生している
+static void int_check_done(void) {
+	if (hal_int_level()) return;
+	if (FLAGS & F_ALARM) return; // 前回分の処理待ち
+	FLAGS |= F_ALARM;
+	event_post(EVT_ALARM);
 }
 
-// uU[Jn
-void buzzer_start(void) {
-	// CTC[hiWGM01 = 1jAToggle OC0A on compare matchiCOM0A0 = 1j
-	TCCR0A = (1 << COM0A0) | (1 << WGM01);
-	TCCR0B = (1 << CS00);  // vXP[ 1
-	// rvl̐ݒi4kHzjFout = F_CPU/(2*Prescaler*(1+OCR0A)) = 1000000/(2*1*(1+124))?4000Hz
-	OCR0A = 124;
+// RTC更新処理：Control1?年を1バーストで読み出し（再同期）
+int process_rtc_update(void) {
+	sync_seq = sec_seq;
+	return rtc_sync(RTC_CTRL1, RTC_YEAR, rtc_update_done);
 }
 
-// uU[~
-void buzzer_stop(void) {
-	TCCR0A = 0; // PWM
-	TCCR0B = 0; // NbN~
-	PORTD &= ~(1<<PD6); // PD6LOW
+// RTC読み出し完了（TWI割込み内）：取り込みはメインループで
+void rtc_update_done(void) {
+	event_post(EVT_RTC);
 }
 
-// XCb`ǂݎ
-void read_switches(void) {
-	static uint8_t last_s1 = 0, last_s2 = 0; // l0ij
-	uint8_t s1 = !(PINC & (1 << PC2)); // Switch1 (PC2)
-	uint8_t s2 = !(PINC & (1 << PC3)); // Switch2 (PC3)
-	static uint16_t auto_count_timer = 0; // JEgp^C}[
-	static uint16_t date_long_press_time = 0; // S2iNݒpj
-	static uint8_t skip_next_s2_release = 0; // S2̒lύXXLbvtO
-	static uint8_t skip_next_s1_release = 0; // S1̃[hJڂXLbvtO
-
-	// MODE_NORMAL: 2bŎݒAS112/24؂ւAS2ŔN\
-	if (mode == MODE_NORMAL) {
-		if (s1 && s2 && last_s1 && last_s2) {
-			if (++switch_press_time >= 2000) { // 2bŎݒ
-				mode = MODE_SET_HOUR;
-				switch_press_time = 0;
-				waiting_for_release = 1; // XCb`ҋ@
-				skip_next_s2_release = 1; // S2XLbv
-				skip_next_s1_release = 1; // S1XLbv
-				rtc_read_time(&hour, &min, &sec);
-				is_am = (hour < 12);
-			}
-			} else {
-			switch_press_time = 0;
-			// S1PƉ12/24Ԑ؂ւij
-			if (s1 == 0 && last_s1 == 1 && !s2) {
-				is_24hour ^= 1;
-				if (!is_24hour) led7_timer = 2000; // 2412LED7_2b
-				_delay_us(100); // ȈՃfoEX
-			}
-			// S2PƉŔN\ij
-			if (s2 == 0 && last_s2 == 1 && !s1) {
-				mode = MODE_DATE_DISP;
-				date_display_timer = DATE_DISP_TIME; // 2b^C}[Jn
-				rtc_read_date(&year, &month, &day); // RTCNǂݍ
-				_delay_us(100); // ȈՃfoEX
-			}
-		}
+// 再描画要求（割込み内、処理待ちの要求があれば投入しない）
+static void redraw(void) {
+	if (FLAGS & F_REDRAW) return;
+	FLAGS |= F_REDRAW;
+	event_post(EVT_REDRAW);
+}
+
+// コロン消灯
+static void colon_done(void) {
+	FLAGS &= ~F_COLON;
+	redraw();
+}
+
+// LED8消灯
+static void led8_done(void) {
+	FLAGS &= ~F_LED8;
+	redraw();
+}
+
+// LED7消灯（12時間表示切替時の点灯終了）
+static void led7_done(void) {
+	redraw();
+}
+
+// 点滅位相反転
+static void blink_done(void) {
+	FLAGS ^= F_BLINK;
+	redraw();
+}
+
+// 年月日表示タイマー満了
+static void date_disp_done(void) {
+	event_post(EVT_TIMER | TMR_DATE_DISP);
+}
+
+// 年月日表示の自動復帰（S2押下中は延長）
+static void date_disp_end(void) {
+	if (mode != MODE_DATE_DISP) return;
+	if (input_held() & IN_S2) timer_start(&date_disp_tmr, DATE_DISP_TIME, 0);
+	else mode = MODE_NORMAL; // 2秒で通常モード
+}
+
+// 設定保存タイマー満了
+static void save_done(void) {
+	event_post(EVT_TIMER | TMR_SAVE);
+}
+
+// 設定変更の通知：最後の変更からSAVE_DELAY_MS後にまとめて保存
+static void settings_changed(void) {
+	timer_start(&save_tmr, SAVE_DELAY_MS, 0);
+}
+
+// 現在の設定をEEPROMへ（保存済みと同じなら書かない）
+static void settings_store(void) {
+	settings_t s = {0};
+	s.flags = (CONF & C_24H) ? SET_24H : 0;
+	for (uint8_t i = 0; i < 4; i++) {
+		alarm_t *a = &alarm_tab[ALARM_USER + i];
+		s.alarm[i][0] = a->hour | (a->enabled ? SET_AL_EN : 0);
+		s.alarm[i][1] = a->min;
 	}
-	// MODE_DATE_DISP: S2ŔNݒA2bŒʏ탂[h
-	else if (mode == MODE_DATE_DISP) {
-		if (s2 && last_s2) {
-			switch2_pressed = 1; // S2
-			if (++date_long_press_time >= 2000) { // 2bŔNݒ
-				mode = MODE_SET_YEAR;
-				date_long_press_time = 0;
-				waiting_for_release = 1; // XCb`ҋ@
-				skip_next_s2_release = 1; // S2XLbv
-				rtc_read_date(&year, &month, &day); // lǂݍ
-			}
-			} else {
-			switch2_pressed = 0; // S2ꂽ
-			date_long_press_time = 0;
-		}
-		if (!s2 && !last_s2) { // S2łȂꍇA^C}[
-			if (date_display_timer > 0) date_display_timer--;
-			if (date_display_timer == 0) mode = MODE_NORMAL; // 2bŒʏ탂[h
-		}
+	s.dim = dim_set;
+	s.night[0] = night[0];
+	s.night[1] = night[1];
+	s.trim[0] = dim_trim;
+	s.trim[1] = dim_trim >> 8;
+	if (!settings_save(&s)) timer_start(&save_tmr, SAVE_RETRY_MS, 0); // 前回の書き込み中
+}
+
+// 保存済みの設定を反映（起動時）
+static void settings_apply(const settings_t *s) {
+	CONF = (s->flags & SET_24H) ? C_24H : 0;
+	for (uint8_t i = 0; i < 4; i++) {
+		uint8_t h = s->alarm[i][0];
+		alarm_set(ALARM_USER + i, h & ~SET_AL_EN, s->alarm[i][1], (h & SET_AL_EN) ? 1 : 0);
 	}
-	// /Nݒ胂[h
-	else {
-		// XCb`ҋ@
-		if (waiting_for_release) {
-			if (s1 == 0 && s2 == 0) {
-				waiting_for_release = 0;
-				_delay_us(100); // ȈՃfoEX
+	dim_set = s->dim;
+	night[0] = s->night[0];
+	night[1] = s->night[1];
+	dim_trim = s->trim[0] | ((uint16_t)s->trim[1] << 8);
+}
+
+// 入力アクション
+#define ACT_NONE        0
+#define ACT_TOGGLE_24H  1 // 12/24時間切り替え
+#define ACT_DATE_DISP   2 // 年月日表示
+#define ACT_SET_TIME    3 // 時刻設定開始
+#define ACT_SET_DATE    4 // 年月日設定開始
+#define ACT_NEXT        5 // 次の設定項目（最後は保存）
+#define ACT_INC         6 // 設定中の値を+1
+#define ACT_SW_ENTER    7 // ストップウォッチへ
+#define ACT_SW_START    8 // 開始/停止
+#define ACT_SW_LAP      9 // ラップ表示中：解除、動作中：ラップ表示の固定、停止中：リセット
+#define ACT_SW_NEXT     10 // 次のモード（ストップウォッチ→カウントダウン→通常）
+#define ACT_CD_SET      11 // 停止中：リセット、ゼロから開始前なら設定時間+1分
+
+// 入力遷移テーブル [モード][イベント] → アクション
+static const uint8_t input_table[MODE_NUM][EV_NUM] = {
+	//  S1_SHORT        S2_SHORT       S2_LONG       COMBO_LONG    S2_REPEAT
+	{ACT_TOGGLE_24H, ACT_DATE_DISP, ACT_SW_ENTER, ACT_SET_TIME, ACT_NONE}, // MODE_NORMAL
+	{ACT_NEXT,       ACT_INC,       ACT_NONE,     ACT_NONE,     ACT_INC }, // MODE_SET_HOUR
+	{ACT_NEXT,       ACT_INC,       ACT_NONE,     ACT_NONE,     ACT_INC }, // MODE_SET_MIN
+	{ACT_NEXT,       ACT_INC,       ACT_NONE,     ACT_NONE,     ACT_INC }, // MODE_SET_SEC
+	{ACT_NONE,       ACT_NONE,      ACT_NONE,     ACT_NONE,     ACT_NONE}, // MODE_SAVE
+	{ACT_NONE,       ACT_NONE,      ACT_SET_DATE, ACT_NONE,     ACT_NONE}, // MODE_DATE_DISP
+	{ACT_NEXT,       ACT_INC,       ACT_NONE,     ACT_NONE,     ACT_INC }, // MODE_SET_YEAR
+	{ACT_NEXT,       ACT_INC,       ACT_NONE,     ACT_NONE,     ACT_INC }, // MODE_SET_MONTH
+	{ACT_NEXT,       ACT_INC,       ACT_NONE,     ACT_NONE,     ACT_INC }, // MODE_SET_DAY
+	{ACT_SW_START,   ACT_SW_LAP,    ACT_NONE,     ACT_SW_NEXT,  ACT_NONE}, // MODE_STOPWATCH
+	{ACT_SW_START,   ACT_CD_SET,    ACT_NONE,     ACT_SW_NEXT,  ACT_CD_SET}  // MODE_COUNTDOWN
+};
+
+// ストップウォッチ・カウントダウン（メインループのみ）
+#define CD_PRESET_SEC      180  // カウントダウンの初期設定時間（3分）
+#define CD_STEP_SEC        60   // 設定時間の増分
+static sw_time_t lap;            // 固定表示中のラップ
+static uint8_t lap_hold;         // ラップ表示中（計測は継続）
+static uint16_t cd_preset = CD_PRESET_SEC; // カウントダウンの設定時間（秒）
+
+// 表示する時間：ラップまたは経過、カウントダウンは残り（99:59.99で止める）
+static void sw_value(sw_time_t *t) {
+	if (lap_hold) *t = lap;
+	else sw_get(t);
+	if (mode == MODE_COUNTDOWN) {
+		if (t->sec >= cd_preset) {
+			t->sec = 0;
+			t->ms = 0;
+		} else {
+			t->sec = cd_preset - t->sec;
+			if (t->ms) {
+				t->sec--;
+				t->ms = 1000 - t->ms;
 			}
-			return; // ҋ@͏XLbv
 		}
-		// ݒ葀
-		// S1: [hJځij
-		if (s1 == 0 && last_s1 == 1 && !skip_next_s1_release) {
-			if (mode == MODE_SET_DAY) { // ݒɕۑ[h
-				mode = MODE_SAVE;
-				} else if (mode == MODE_SET_SEC) { // bݒɕۑ[h
-				mode = MODE_SAVE;
-				} else {
-				mode++; // ̃[hցiMODE_DATE_DISP̓XLbvj
-				if (mode == MODE_DATE_DISP) mode = MODE_NORMAL;
-			}
-			if (mode == MODE_SAVE) {
-				// ۑ
-				if (last_mode >= MODE_SET_HOUR && last_mode <= MODE_SET_SEC) {
-					set_rtc_time(hour, min, sec); // 
-					} else if (last_mode >= MODE_SET_YEAR && last_mode <= MODE_SET_DAY) {
-					rtc_write_date(year, month, day); // N
-					_delay_us(100); // I2C݊ۏ
-				}
-				mode = MODE_NORMAL;
-				waiting_for_release = 1; // ۑɉҋ@
-				skip_next_s2_release = 1; // ۑS2XLbv
-				skip_next_s1_release = 1; // ۑS1XLbv
+	}
+	if (t->sec > SW_MAX_SEC) {
+		t->sec = SW_MAX_SEC;
+		t->ms = 999;
+	}
+}
+
+// 動作中の上限・満了判定（再描画ごと）
+static void sw_check(void) {
+	sw_time_t t;
+	if (!sw_running()) return;
+	sw_get(&t);
+	if (mode == MODE_COUNTDOWN && t.sec >= cd_preset) {
+		sw_stop();
+		buzzer_play(mel_alarm);
+	} else if (t.sec > SW_MAX_SEC) {
+		sw_stop();
+	}
+}
+
+// ストップウォッチのモード切り替え（停止してゼロへ）
+static void sw_enter(uint8_t m) {
+	mode = m;
+	sw_reset();
+	lap_hold = 0;
+	input_lock();
+}
+
+// スイッチ読み取り：デバウンスとイベント生成（待ちなし、Timer1割込み内）
+// 処理はメインループでテーブルを引いて行う
+void read_switches(void) {
+	uint8_t ev = input_tick();
+
+	for (uint8_t e = 0; ev; e++, ev >>= 1) {
+		if (ev & 1) event_post(EVT_INPUT | e);
+	}
+	uint8_t en = (input_held() & IN_S2) ? 0 : F_BLINK_EN; // S2押下中は点滅停止
+	if ((FLAGS & F_BLINK_EN) != en) {
+		FLAGS ^= F_BLINK_EN;
+		redraw();
+	}
+}
+
+// 入力アクション実行
+void input_action(uint8_t act) {
+	bcdtime_t t;
+
+	switch (act) {
+		case ACT_TOGGLE_24H:
+			CONF ^= C_24H;
+			if (!(CONF & C_24H)) timer_start(&led7_tmr, LED7_MS, 0); // 24→12でLED7点灯2秒
+			settings_changed();
+			break;
+		case ACT_DATE_DISP:
+			mode = MODE_DATE_DISP; // 年月日は動作中の時計から表示
+			timer_start(&date_disp_tmr, DATE_DISP_TIME, 0); // 2秒タイマー開始
+			break;
+		case ACT_SET_TIME: // 設定の初期値は動作中の時計（シャドウは再同期時点の古い値）
+			mode = MODE_SET_HOUR;
+			input_lock(); // スイッチ解放まで無視
+			break;
+		case ACT_SET_DATE:
+			mode = MODE_SET_YEAR;
+			timer_stop(&date_disp_tmr);
+			input_lock();
+			break;
+		case ACT_NEXT:
+			clock_get(&t);
+			if (mode == MODE_SET_SEC) { // 秒設定後に保存
+				set_rtc_time(t.hour, t.min, t.sec); // 時刻書き込み
+				alarm_load(t.hour, t.min); // 新しい時刻から次のアラームを設定
+			} else if (mode == MODE_SET_DAY) { // 日設定後に保存
+				rtc_write_date(t.year, t.month, t.day); // 年月日書き込み
+			} else {
+				mode++; // 次の設定項目へ
+				break;
 			}
-			switch2_hold_time = 0;
-			_delay_us(100); // ȈՃfoEX
-		}
-		// S1̃XLbvtOZbg
-		if (s1 == 0 && last_s1 == 1) {
-			skip_next_s1_release = 0;
-		}
-		// S2: lύXi܂͒j- ҋ@̓XLbv
-		if (!waiting_for_release) {
-			if (s2 == 0 && last_s2 == 1 && !skip_next_s2_release) {
-				if (mode == MODE_SET_HOUR) {
-					hour = (hour + 1) % 24;
-					is_am = (hour < 12);
-					} else if (mode == MODE_SET_MIN) {
-					min = (min + 1) % 60;
-					} else if (mode == MODE_SET_SEC) {
-					sec = (sec + 1) % 60;
-					} else if (mode == MODE_SET_YEAR) {
-					year = (year + 1) % 100;
-					} else if (mode == MODE_SET_MONTH) {
-					month = (month % 12) + 1; // 1-12
-					} else if (mode == MODE_SET_DAY) {
-					day = (day % 31) + 1; // 1-31
-				}
-				switch2_hold_time = 0;
-				_delay_us(100); // ȈՃfoEX
+			mode = MODE_NORMAL;
+			FLAGS |= F_RESYNC; // 書き込み後にRTCから読み直す
+			input_lock();
+			break;
+		case ACT_INC:
+			set_value_inc();
+			break;
+		case ACT_SW_ENTER:
+			sw_enter(MODE_STOPWATCH);
+			break;
+		case ACT_SW_NEXT:
+			sw_enter(mode == MODE_STOPWATCH ? MODE_COUNTDOWN : MODE_NORMAL);
+			break;
+		case ACT_SW_START:
+			if (sw_running()) {
+				sw_stop();
+			} else {
+				sw_time_t e;
+				sw_get(&e);
+				if (mode == MODE_STOPWATCH || e.sec < cd_preset) sw_start(); // 満了後はリセットまで開始しない
 			}
-			// S2i10HzJEgAbvj
-			if (s2 == 1) {
-				switch2_hold_time++;
-				if (switch2_hold_time >= 500) { // 0.5b
-					if (++auto_count_timer >= 100) { // 100msƁi10Hzj
-						if (mode == MODE_SET_HOUR) {
-							hour = (hour + 1) % 24;
-							is_am = (hour < 12);
-							} else if (mode == MODE_SET_MIN) {
-							min = (min + 1) % 60;
-							} else if (mode == MODE_SET_SEC) {
-							sec = (sec + 1) % 60;
-							} else if (mode == MODE_SET_YEAR) {
-							year = (year + 1) % 100;
-							} else if (mode == MODE_SET_MONTH) {
-							month = (month % 12) + 1;
-							} else if (mode == MODE_SET_DAY) {
-							day = (day % 31) + 1;
-						}
-						auto_count_timer = 0;
-					}
-				}
-				} else {
-				switch2_hold_time = 0;
-				auto_count_timer = 0;
+			break;
+		case ACT_SW_LAP:
+			if (lap_hold) { // ラップ固定中は解除が先（停止後も最終時間を見せてからリセット）
+				lap_hold = 0;
+			} else if (!sw_running()) {
+				sw_reset();
+			} else {
+				sw_get(&lap);
+				lap_hold = 1;
 			}
-			// S2̃XLbvtOZbg
-			if (s2 == 0 && last_s2 == 1) {
-				skip_next_s2_release = 0;
+			break;
+		case ACT_CD_SET:
+			if (!sw_running()) {
+				sw_time_t e;
+				sw_get(&e);
+				if (e.sec || e.ms) sw_reset();
+				else cd_preset = (cd_preset >= 99 * 60) ? CD_STEP_SEC : cd_preset + CD_STEP_SEC;
 			}
-		}
-		// _ŐiS2̂ݓ_ŁAŒ~j
-		blink_enabled = (s2 == 0 && switch2_hold_time < 500); // S2̂ݓ_
+			break;
 	}
+}
+
+// 設定中の値を+1（BCD）
+void set_value_inc(void) {
+	bcdtime_t t;
 
-	last_s1 = s1;
-	last_s2 = s2;
-	last_mode = mode;
+	clock_get(&t);
+	switch (mode) {
+		case MODE_SET_HOUR:  t.hour = bcd_inc(t.hour, 0x00, 0x23); break;
+		case MODE_SET_MIN:   t.min = bcd_inc(t.min, 0x00, 0x59); break;
+		case MODE_SET_SEC:   t.sec = bcd_inc(t.sec, 0x00, 0x59); break;
+		case MODE_SET_YEAR:  t.year = bcd_inc(t.year, 0x00, 0x99); break;
+		case MODE_SET_MONTH: t.month = bcd_inc(t.month, 0x01, 0x12); break; // 1-12
+		case MODE_SET_DAY:   t.day = bcd_inc(t.day, 0x01, 0x31); break;     // 1-31
+	}
+	clock_put(&t);
 }
 
-// RTCݒ
+// RTC時刻設定（BCD、1バースト、ブロックしない）
 void set_rtc_time(uint8_t h, uint8_t m, uint8_t s) {
-	if (h > 23) h = 0; // ͈͊O␳
-	if (m > 59) m = 0;
-	if (s > 59) s = 0;
-	i2c_start(0xA2);
-	i2c_send(0x02);
-	i2c_send(dec2bcd(s)); // VLrbg͏݂0ɂȂ͂
-	i2c_send(dec2bcd(m));
-	i2c_send(dec2bcd(h));
-	i2c_stop();
-
-	// VLrbgmF
-	i2c_start(0xA2); // RTC݃AhX
-	i2c_send(0x02); // bWX^w
-	i2c_stop();
-	
-	i2c_start(0xA3); // RTCǂݏoAhX
-	uint8_t sec_data = i2c_recv(0); // bWX^ǂݏo
-	i2c_stop();
-	
-	led7_always_on = (sec_data & (1 << 7)) ? 1 : 0; // VLrbgɊÂtOXV
+	if (h > 0x23) h = 0; // 範囲外補正（BCD）
+	if (m > 0x59) m = 0;
+	if (s > 0x59) s = 0;
+	rtc_write(RTC_SEC, s); // VLビットは書き込みで0になる（次回の同期で確認）
+	rtc_write(RTC_MIN, m);
+	rtc_write(RTC_HOUR, h);
+	rtc_flush();
+	CONF &= ~C_LED7_ON; // 書き込みでVLビットは0になる
 }
 
-// Timer1荞݁F_Őƃ^C}[ǗAXCb`ǂݎ
+// Timer1割り込み：タイマー管理、スイッチ読み取り（処理はイベントでメインループへ）
 ISR(TIMER1_COMPA_vect) {
-	static uint16_t blink = 0;
-	static uint8_t blink_state = 1;
-
-	// ^C}[XVi1msPʁj
-	if (++blink >= BLINK_CYCLES) { // 0.25s (4Hz)
-		blink_state ^= 1;
-		blink = 0;
-	}
-	if (colon_blink_state && ++colon_timer >= COLON_CYCLES) {
-		colon_blink_state = 0;
-		colon_timer = 0;
-	}
-	if (led8_state && ++led8_timer >= LED8_CYCLES) {
-		led8_state = 0;
-		led8_timer = 0;
-	}
-	if (led7_timer) led7_timer--;
-	if (buzzer_timer) {
-		uint8_t t = buzzer_timer--;
-		if (t == BUZZER_ON1_START || t == BUZZER_ON2) buzzer_start();
-		else if (t == BUZZER_OFF1 || t == BUZZER_OFF2) buzzer_stop();
-	}
-
-	// XCb`ǂݎ^C}[1Ŏs
-	read_switches();
-
-	// 7ZO\f[^XV
-	if (mode == MODE_DATE_DISP || mode == MODE_SET_YEAR || mode == MODE_SET_MONTH || mode == MODE_SET_DAY) {
-		// N\i25.06.09j
-		seg[0] = mask(day % 10); // ̈
-		seg[1] = mask(day / 10); // \̈
-		seg[2] = mask(month % 10) & ~LED8_MASK; // ̈ʁihbg_j
-		seg[3] = mask(month / 10); // \̈
-		seg[4] = mask(year % 10) & ~LED8_MASK; // N̈ʁihbg_j
-		seg[5] = mask(year / 10); // N\̈
-		} else {
-		// \
-		uint8_t display_hour;
-		if (is_24hour) {
-			display_hour = hour;
-			} else {
-			if (hour < 12) display_hour = hour; // ߑO: 0?11
-			else if (hour == 12) display_hour = hour; // ߌ12:00?12:59
-			else display_hour = hour - 12; // ߌ01:00?11:59
-		}
-		if (mode == MODE_NORMAL || mode == MODE_SAVE) {
-			seg[0] = mask(sec % 10);
-			seg[1] = mask(sec / 10);
-			seg[2] = mask(min % 10);
-			seg[3] = mask(min / 10);
-			seg[4] = mask(display_hour % 10);
-			seg[5] = mask(display_hour / 10 ? display_hour / 10 : 99);
-			} else if (mode == MODE_SET_HOUR) {
-			seg[0] = mask(sec % 10);
-			seg[1] = mask(sec / 10);
-			seg[2] = mask(min % 10);
-			seg[3] = mask(min / 10);
-			seg[4] = mask(hour % 10); // ݒ蒆0?23\
-			seg[5] = mask(hour / 10 ? hour / 10 : 99);
-			} else if (mode == MODE_SET_MIN) {
-			seg[0] = mask(sec % 10);
-			seg[1] = mask(sec / 10);
-			seg[2] = mask(min % 10);
-			seg[3] = mask(min / 10);
-			seg[4] = mask(hour % 10);
-			seg[5] = mask(hour / 10 ? hour / 10 : 99);
-			} else if (mode == MODE_SET_SEC) {
-			seg[0] = mask(sec % 10);
-			seg[1] = mask(sec / 10);
-			seg[2] = mask(min % 10);
-			seg[3] = mask(min / 10);
-			seg[4] = mask(hour % 10);
-			seg[5] = mask(hour / 10 ? hour / 10 : 99);
-		}
+	PROF_TICK();
+	PROF_ENTER();
+#if SLEEP_STATS
+	// 起床率の標本化（割込み時点でメインループが起きていたか）
+	static uint16_t awake_cnt = 0, sample_cnt = 0;
+	if (!(FLAGS & F_IDLE)) awake_cnt++;
+	if (++sample_cnt >= TICK_HZ) {
+		awake_permille = awake_cnt;
+		awake_cnt = 0;
+		sample_cnt = 0;
+	}
+#endif
+
+	// ソフトウェアタイマー更新（満了分のみ処理）
+	timer_tick();
+
+	// I2C転送の応答監視
+	i2c_tick();
+
+	// ストップウォッチ：動作中は10msごとに再描画
+	if (sw_tick()) redraw();
+
+	// スイッチ読み取り（押下中・変化直後のみ、定常時はPCINT1待ち）
+	if (input_active) read_switches();
+
+	PROF_MISSED(TIFR1 & (1<<OCF1A), prof.t1_missed); // 次の比較一致が発生済み
+	PROF_EXIT(PROF_T1);
+}
+
+// 多重化ポートイメージ生成（1スロット分、seg[i]更新後に呼ぶ）
+void mux_render(uint8_t i) {
+	uint8_t dim = (dim_now & 0x0F) + ((dim_trim >> (i * 2)) & 3);
+	uint8_t on = mux_on[dim > BRIGHT_MAX ? 0 : BRIGHT_MAX - dim];
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { // Timer2が書きかけのスロットを出力しないように
+		mux_img[i][0] = seg[i];
+		mux_img[i][1] = HAL_PORTC_IDLE | mux_com[i][0];
+		mux_img[i][2] = mux_com[i][1];
+		mux_img[i][3] = on;
+	}
+}
+
+// 時間帯による輝度の切り替え（夜間は開始時から終了時の前まで、日付をまたいでもよい）
+static void bright_update(void) {
+	bcdtime_t t;
+	clock_get(&t);
+	uint8_t h = t.hour, on = night[0], off = night[1];
+	uint8_t is_night = (on <= off) ? (h >= on && h < off) : (h >= on || h < off);
+	uint8_t d = is_night ? (dim_set >> 4) : (dim_set & 0x0F);
+	if (d == dim_now) return;
+	dim_now = d;
+	for (uint8_t i = 0; i < 7; i++) mux_render(i);
+}
+
+// 表示更新：ソース値が変化したフィールド（2桁単位）のみ再描画
+void render_update(void) {
+	static uint8_t shown_val[3] = {0xFF, 0xFF, 0xFF}; // 描画済みの値（0xFF: 未描画）
+	static uint8_t shown_attr[3];                      // 描画済みの属性
+	uint8_t view = mode_disp[mode][0];
+	uint8_t blink_field = mode_disp[mode][1];
+	uint8_t val[3];
+	bcdtime_t t;
+
+	clock_get(&t); // 一貫した時刻のコピー
+	if (view == VIEW_DATE) {
+		val[0] = t.day;
+		val[1] = t.month;
+		val[2] = t.year;
+	} else if (view == VIEW_SW) { // 16bitの除算のみ（100Hzで呼ばれる）
+		sw_time_t w;
+		sw_value(&w);
+		val[0] = bin_bcd(w.ms / 10);
+		val[1] = bin_bcd(w.sec % 60);
+		val[2] = bin_bcd(w.sec / 60);
+	} else {
+		val[0] = t.sec;
+		val[1] = t.min;
+		val[2] = t.hour;
+		if (view == VIEW_CLOCK && !(CONF & C_24H)) val[2] = bcd_to12(val[2]); // 午後01:00?11:59
 	}
 
-	// _Ő: Kvɉseg[]
-	if (blink_enabled && mode != MODE_NORMAL && mode != MODE_SAVE && mode != MODE_DATE_DISP && !blink_state) {
-		for (uint8_t i = blink_range[mode][0]; i < blink_range[mode][1]; i++) {
-			seg[i] = 0xFF; // 
+	for (uint8_t f = 0; f < 3; f++) {
+		uint8_t attr = 0;
+		if (view == VIEW_DATE) attr |= ATTR_DOT; // 年月日表示時はドット点灯
+		else if (view == VIEW_SW && f == 1) attr |= ATTR_DOT; // 秒と1/100秒の区切り
+		else if (f == 2) attr |= ATTR_ZS;        // 時の十の位はゼロサプレス
+		if (f == blink_field && (FLAGS & F_BLINK_EN) && !(FLAGS & F_BLINK)) attr |= ATTR_BLANK;
+
+		if (val[f] == shown_val[f] && attr == shown_attr[f]) continue;
+		shown_val[f] = val[f];
+		shown_attr[f] = attr;
+
+		uint8_t lo = SEG_BLANK, hi = SEG_BLANK;
+		if (!(attr & ATTR_BLANK)) {
+			uint8_t tens = val[f] >> 4;
+			lo = mask(val[f]);
+			if (tens || !(attr & ATTR_ZS)) hi = mask(tens);
 		}
+		if (attr & ATTR_DOT) lo &= ~LED8_MASK; // 点滅中もドットは点灯
+		seg[f * 2] = lo;
+		seg[f * 2 + 1] = hi;
+		mux_render(f * 2);
+		mux_render(f * 2 + 1);
 	}
 
-	// COM6iRAAM/PMALED7/8j̍XV
+	// COM6（コロン、AM/PM、LED7/8）の更新
 	uint8_t com = 0xFF;
-	if (mode == MODE_NORMAL || mode == MODE_SET_HOUR || mode == MODE_SET_MIN || mode == MODE_SET_SEC || mode == MODE_SAVE) {
-		if (mode != MODE_NORMAL || colon_blink_state) com &= ~COLON_MASK;
-		com &= is_am ? ~AM_MASK : ~PM_MASK;
+	if (view != VIEW_DATE) {
+		if (mode != MODE_NORMAL || (FLAGS & F_COLON)) com &= ~COLON_MASK;
+		if (view != VIEW_SW) com &= clock_is_am(&t) ? ~AM_MASK : ~PM_MASK;
+	}
+	if (FLAGS & F_LED8) com &= ~LED8_MASK;
+	if (timer_active(&led7_tmr) || (CONF & C_LED7_ON)) com &= ~LED7_MASK; // LED7常時点灯またはタイマー点灯
+	if (com != seg[6]) {
+		seg[6] = com;
+		mux_render(6);
 	}
-	if (led8_state) com &= ~LED8_MASK;
-	if (led7_timer || led7_always_on) com &= ~LED7_MASK; // LED7펞_܂̓^C}[_
-	seg[6] = com;
 }
 
-// Timer2荞݁F7ZOd
+// Timer2割り込み：7セグ多重化（生成済みイメージを出力するだけ）
 ISR(TIMER2_COMPA_vect) {
-	// S
-	PORTB = 0xFF;
-	PORTD &= 0x4C; // seg,com low 0b01001100
-	PORTC &= 0xFC; // seg low 0b11111100
-
-	// ZOgf[^o
-	PORTB = seg[mx];
-	// N\ɃhbgiPB5j_imx=2,4j
-	if (mode == MODE_DATE_DISP || mode == MODE_SET_YEAR || mode == MODE_SET_MONTH || mode == MODE_SET_DAY) {
-		if (mx == 2 || mx == 4 || mx == 0) {
-			PORTB &= ~_BV(PORTB5); // PB5LOWihbg_j
+	static const uint8_t *p = mux_img[0];
+	PROF_ENTER();
+
+	hal_mux_out(p, PROF_PD | UART_PD);
+	hal_mux_on_time(p[3], PROF_PD | UART_PD);
+
+	// ポインタ更新
+	p += 4;
+	if (p == mux_img[7]) p = mux_img[0];
+
+	PROF_MISSED(TIFR2 & (1<<OCF2A), prof.t2_missed);
+	PROF_EXIT(PROF_T2);
+}
+
+#if UART_CONSOLE
+// USARTコンソール（1行1コマンド、数値は2桁16進、時刻・年月日はBCDの10進表記）
+//   R                 時刻読み出し → "R YYMMDDhhmmss"
+//   S YYMMDDhhmmss    RTCを停止（STOP=1）して年月日・時刻を書き込み、Gまで保持
+//   G                 RTC再開（STOP=0）：受信した時点が新しい秒の開始になる
+//   P nn [vv]         設定nnの読み出し・書き込み → "P nn vv"
+//   Q [nn]            統計を1回送信、nnを付けるとnn秒ごとに送信（00で停止）
+#define SYNC_HOLD_MS       2000 // S受信後Gが来ないまま停止を保つ最大時間
+#define PARAM_24H          0x00 // 設定：24時間表記（0/1）
+#define PARAM_DAY          0x01 // 設定：昼の輝度（0?7）
+#define PARAM_NIGHT        0x02 // 設定：夜の輝度（0?7）
+#define PARAM_NIGHT_ON     0x03 // 設定：夜間開始時（BCD、終了時と同じなら夜間なし）
+#define PARAM_NIGHT_OFF    0x04 // 設定：夜間終了時（BCD）
+#define PARAM_TRIM         0x10 // 設定：桁ごとの減光0?3（0x10?0x16：スロット0?6）
+#define PARAM_AL_HOUR      0x20 // 設定：ユーザーアラームの時（BCD、bit7:有効、0x20?0x23：アラーム0?3）
+#define PARAM_AL_MIN       0x30 // 設定：ユーザーアラームの分（BCD、0x30?0x33：アラーム0?3）
+#define STAT_LINE_MAX      36   // 統計1行の最大長（送信リングに空きがあるときだけ送る）
+#define STAT_DONE          0xFF
+
+static void sync_timeout(void) {
+	event_post(EVT_TIMER | TMR_SYNC);
+}
+static swtimer_t sync_tmr = SWTIMER(sync_timeout); // RTC停止の自動解除
+static uint8_t sync_hold;                          // S受信からG待ち（メインループのみ）
+static uint8_t stat_period;                        // 統計の自動送信間隔（秒、0で停止）
+static uint8_t stat_timer;                         // 前回の自動送信からの秒数
+static uint8_t stat_line = STAT_DONE;              // 次に送る統計行
+
+// 2桁16進（bcd=1では各桁0?9のみ）、不正なら-1
+static int16_t con_hex2(const char *s, uint8_t bcd) {
+	uint8_t v = 0;
+	for (uint8_t i = 0; i < 2; i++) {
+		char c = s[i];
+		uint8_t d;
+		if (c >= '0' && c <= '9') d = c - '0';
+		else if (!bcd && c >= 'A' && c <= 'F') d = c - 'A' + 10;
+		else return -1;
+		v = (v << 4) | d;
+	}
+	return v;
+}
+
+static void con_reply(uint8_t ok) {
+	uart_puts_P(ok ? PSTR("OK\r\n") : PSTR("ERR\r\n"));
+}
+
+// RTC再開（G受信またはタイムアウト）
+static void sync_release(void) {
+	bcdtime_t now;
+	if (!sync_hold) return;
+	sync_hold = 0;
+	timer_stop(&sync_tmr);
+	rtc_write(RTC_CTRL1, 0x10); // STOP=0, TI/TP=1：分周器はリセット済みなので1秒後に最初の/INT
+	rtc_flush();
+	clock_get(&now);
+	alarm_load(now.hour, now.min); // 新しい時刻から次のアラームを設定
+}
+
+// S YYMMDDhhmmss：停止中に1秒の境界を待たず書き込めるよう、STOPを先に送る
+static uint8_t con_set(const char *s) {
+	uint8_t v[6];
+	static const uint8_t lim[6][2] PROGMEM = {
+		{0x00, 0x99}, {0x01, 0x12}, {0x01, 0x31}, {0x00, 0x23}, {0x00, 0x59}, {0x00, 0x59}
+	};
+	if (mode != MODE_NORMAL && mode != MODE_DATE_DISP) return 0; // スイッチで設定中
+	for (uint8_t i = 0; i < 6; i++) {
+		int16_t x = con_hex2(s + i * 2, 1);
+		if (x < pgm_read_byte(&lim[i][0]) || x > pgm_read_byte(&lim[i][1])) return 0;
+		v[i] = x;
+	}
+	if (s[12]) return 0;
+
+	rtc_write(RTC_CTRL1, 0x20); // STOP=1（書き込み順に送られるため時刻より先）
+	rtc_flush();
+	set_rtc_time(v[3], v[4], v[5]);
+	rtc_write_date(v[0], v[1], v[2]);
+	bcdtime_t t = { v[5], v[4], v[3], v[2], v[1], v[0] };
+	clock_put(&t); // 書き込んだ時刻をそのまま表示へ
+	sync_hold = 1;
+	timer_start(&sync_tmr, SYNC_HOLD_MS, 0);
+	return 1;
+}
+
+// 設定の読み出し（存在しなければ-1）
+static int16_t param_get(uint8_t n) {
+	switch (n) {
+		case PARAM_24H:       return (CONF & C_24H) ? 1 : 0;
+		case PARAM_DAY:       return BRIGHT_MAX - (dim_set & 0x0F);
+		case PARAM_NIGHT:     return BRIGHT_MAX - (dim_set >> 4);
+		case PARAM_NIGHT_ON:  return night[0];
+		case PARAM_NIGHT_OFF: return night[1];
+	}
+	if (n >= PARAM_TRIM && n < PARAM_TRIM + 7) return (dim_trim >> ((n - PARAM_TRIM) * 2)) & 3;
+	if (n >= PARAM_AL_HOUR && n < PARAM_AL_HOUR + 4) {
+		alarm_t *a = &alarm_tab[ALARM_USER + n - PARAM_AL_HOUR];
+		return a->hour | (a->enabled ? SET_AL_EN : 0);
+	}
+	if (n >= PARAM_AL_MIN && n < PARAM_AL_MIN + 4) return alarm_tab[ALARM_USER + n - PARAM_AL_MIN].min;
+	return -1;
+}
+
+// ユーザーアラームの書き込み（範囲外なら0）、RTCのアラームを設定し直す
+static uint8_t param_alarm(uint8_t n, uint8_t v) {
+	uint8_t i = n & 0x0F;
+	alarm_t *a = &alarm_tab[ALARM_USER + i];
+	bcdtime_t now;
+
+	if (i >= 4) return 0;
+	if (n < PARAM_AL_MIN) {
+		uint8_t h = v & ~SET_AL_EN;
+		if (h > 0x23 || (h & 0x0F) > 9) return 0;
+		alarm_set(ALARM_USER + i, h, a->min, (v & SET_AL_EN) ? 1 : 0);
+	} else {
+		if (v > 0x59 || (v & 0x0F) > 9) return 0;
+		alarm_set(ALARM_USER + i, a->hour, v, a->enabled);
+	}
+	clock_get(&now);
+	alarm_load(now.hour, now.min);
+	return 1;
+}
+
+// 設定の書き込み（範囲外なら0）、変更は一定時間後にEEPROMへ保存
+static uint8_t param_set(uint8_t n, uint8_t v) {
+	switch (n) {
+		case PARAM_24H:
+			if (v > 1) return 0;
+			if (v) CONF |= C_24H;
+			else CONF &= ~C_24H;
+			break;
+		case PARAM_DAY:
+		case PARAM_NIGHT:
+			if (v > BRIGHT_MAX) return 0;
+			v = BRIGHT_MAX - v;
+			if (n == PARAM_DAY) dim_set = (dim_set & 0xF0) | v;
+			else dim_set = (dim_set & 0x0F) | (v << 4);
+			break;
+		case PARAM_NIGHT_ON:
+		case PARAM_NIGHT_OFF:
+			if (v > 0x23 || (v & 0x0F) > 9) return 0;
+			night[n - PARAM_NIGHT_ON] = v;
+			break;
+		default:
+			if (n >= PARAM_AL_HOUR) {
+				if (n >= PARAM_AL_MIN + 4 || !param_alarm(n, v)) return 0;
+				break;
+			}
+			if (n < PARAM_TRIM || n >= PARAM_TRIM + 7 || v > 3) return 0;
+			n = (n - PARAM_TRIM) * 2;
+			dim_trim = (dim_trim & ~(3U << n)) | ((uint16_t)v << n);
+			break;
+	}
+	dim_now = 0xFF; // 輝度を全スロット再計算
+	bright_update();
+	settings_changed();
+	return 1;
+}
+
+// 統計1行（n行目、なければ0）
+static uint8_t stat_emit(uint8_t n) {
+	if (n-- == 0) {
+		uart_puts_P(PSTR("Q I2C "));
+		uart_hex8(i2c_err.nack);
+		uart_putc(' ');
+		uart_hex8(i2c_err.bus);
+		uart_putc(' ');
+		uart_hex8(i2c_err.timeout);
+		uart_putc(' ');
+		uart_hex8(i2c_err.recover);
+		uart_putc(' ');
+		uart_hex8(i2c_err.fail);
+	} else if (n-- == 0) {
+		uart_puts_P(PSTR("Q LOST "));
+		uart_hex8(event_lost);
+		uart_putc(' ');
+		uart_hex8(uart_err.rx_lost);
+		uart_putc(' ');
+		uart_hex8(uart_err.rx_err);
+		uart_putc(' ');
+		uart_hex8(uart_err.tx_lost);
+#if PROF_STATS
+	} else if (n < PROF_NUM) {
+		prof_slot_t s;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			s = prof.slot[n];
+		}
+		uint16_t f[5] = {s.min, s.max, s.avg, s.n, s.over};
+		uart_puts_P(PSTR("Q T "));
+		uart_hex8(n);
+		for (uint8_t i = 0; i < 5; i++) {
+			uart_putc(' ');
+			uart_hex16(f[i]);
+		}
+	} else if ((n -= PROF_NUM) == 0) {
+		uint16_t m1, m2, lat;
+		uint32_t boot;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			m1 = prof.t1_missed;
+			m2 = prof.t2_missed;
+			lat = prof.t1_latency;
+			boot = prof.boot;
 		}
+		uart_puts_P(PSTR("Q MISS "));
+		uart_hex16(m1);
+		uart_putc(' ');
+		uart_hex16(m2);
+		uart_putc(' ');
+		uart_hex16(lat);
+		uart_putc(' ');
+		uart_hex16(boot >> 16);
+		uart_hex16(boot);
+	} else if (--n == 0) {
+#else
+	} else if (n == 0) {
+#endif
+		uart_puts_P(PSTR("Q END"));
+	} else {
+		return 0;
+	}
+	uart_puts_P(PSTR("\r\n"));
+	return 1;
+}
+
+// 統計を送信リングの空きの分だけ送る（残りは次の1秒で）
+static void stat_pump(void) {
+	while (stat_line != STAT_DONE && uart_room() >= STAT_LINE_MAX) {
+		if (!stat_emit(stat_line)) stat_line = STAT_DONE;
+		else stat_line++;
 	}
-	// COMsZbg
-	switch (mx) {
-		case 0: PORTD |= (1 << PD0); break; // COM0: b̈
-		case 1: PORTD |= (1 << PD1); break; // COM1: b\̈
-		case 2: PORTC |= (1 << PC0); break; // COM2: ̈
-		case 3: PORTC |= (1 << PC1); break; // COM3: \̈
-		case 4: PORTD |= (1 << PD4); break; // COM4: ̈
-		case 5: PORTD |= (1 << PD5); break; // COM5: \̈
-		case 6: PORTD |= (1 << PD7); break; // COM6: REAM/PMELED7/8
+}
+
+// 1秒ごと：統計の自動送信
+static void console_sec(void) {
+	if (stat_period && ++stat_timer >= stat_period) {
+		stat_timer = 0;
+		if (stat_line == STAT_DONE) stat_line = 0; // 前回分が送り終わっていなければ飛ばす
+	}
+	stat_pump();
+}
+
+// 1行受信：コマンド実行
+static void console_line(void) {
+	char line[UART_LINE_LEN];
+	uint8_t len = uart_getline(line);
+	int16_t n, v;
+	bcdtime_t t;
+
+	if (len == 0) return; // 空行（CR LFの片方）
+	switch (line[0]) {
+		case 'R':
+			clock_get(&t);
+			uart_puts_P(PSTR("R "));
+			uart_hex8(t.year);
+			uart_hex8(t.month);
+			uart_hex8(t.day);
+			uart_hex8(t.hour);
+			uart_hex8(t.min);
+			uart_hex8(t.sec);
+			uart_puts_P(PSTR("\r\n"));
+			break;
+		case 'S':
+			con_reply(line[1] == ' ' && con_set(line + 2));
+			break;
+		case 'G':
+			n = sync_hold;
+			sync_release(); // 応答より先にSTOP解除を送る
+			con_reply(n);
+			break;
+		case 'P':
+			n = (line[1] == ' ') ? con_hex2(line + 2, 0) : -1;
+			if (n >= 0 && line[4] == ' ') { // 書き込み
+				v = con_hex2(line + 5, 0);
+				if (v < 0 || line[7] || !param_set(n, v)) n = -1;
+			} else if (n >= 0 && line[4]) {
+				n = -1;
+			}
+			v = (n >= 0) ? param_get(n) : -1;
+			if (v < 0) {
+				con_reply(0);
+				break;
+			}
+			uart_puts_P(PSTR("P "));
+			uart_hex8(n);
+			uart_putc(' ');
+			uart_hex8(v);
+			uart_puts_P(PSTR("\r\n"));
+			break;
+		case 'Q':
+			if (line[1] == ' ') {
+				n = con_hex2(line + 2, 0);
+				if (n < 0 || line[4]) {
+					con_reply(0);
+					break;
+				}
+				stat_period = n;
+				stat_timer = 0;
+			}
+			stat_line = 0;
+			stat_pump();
+			break;
+		default:
+			con_reply(0);
+			break;
 	}
+}
+#endif
+
+// Timer2比較B：スロット内の点灯時間が過ぎたら消灯
+ISR(TIMER2_COMPB_vect) {
+	hal_mux_blank(PROF_PD | UART_PD);
+}
+
+// イベント処理（メインループ）
+static void dispatch(uint8_t ev) {
+	bcdtime_t now;
 
-	// CfbNXXV
-	mx = (mx + 1) % 7;
+	switch (evt_type(ev)) {
+		case EVT_SEC: // INT0の1Hzで時刻をソフトウェアで進める（設定モード中は停止）
+			if (mode == MODE_NORMAL || mode == MODE_DATE_DISP || mode >= MODE_STOPWATCH) clock_tick();
+			bright_update();
+			if (++resync_timer >= RTC_RESYNC_SEC) FLAGS |= F_RESYNC;
+#if UART_CONSOLE
+			console_sec();
+#endif
+			break;
+		case EVT_ALARM: // アラーム発生：鳴動、AFクリアと次のアラーム設定
+			if (alarm_is_chime(alarm_loaded)) {
+				buzzer_play(mel_chime); // 時報（0時/12時）：20ms発音+60ms消音+20ms発音
+			} else {
+				buzzer_play(mel_alarm);
+			}
+			clock_get(&now);
+			alarm_ack(now.hour, now.min);
+			FLAGS &= ~F_ALARM;
+			break;
+		case EVT_INPUT:
+			input_action(input_table[mode][evt_arg(ev)]);
+			break;
+		case EVT_TIMER:
+			if (evt_arg(ev) == TMR_DATE_DISP) date_disp_end();
+			if (evt_arg(ev) == TMR_SAVE) settings_store();
+#if UART_CONSOLE
+			if (evt_arg(ev) == TMR_SYNC) sync_release();
+#endif
+			break;
+		case EVT_RTC: // 再同期の読み出し完了（設定モード中は取り込まない）
+			if (mode != MODE_NORMAL) break;
+			if (sec_seq != sync_seq) { // 読み出し中に秒が進んだ：clock_tick済みの秒を読み出し時点の値で戻さず読み直す
+				FLAGS |= F_RESYNC;
+				break;
+			}
+			rtc_load_time();
+			rtc_load_date();
+			break;
+		case EVT_REDRAW: // 描画はイベント処理後にまとめて行う
+			FLAGS &= ~F_REDRAW;
+			sw_check();
+			break;
+#if UART_CONSOLE
+		case EVT_UART:
+			console_line();
+			break;
+#endif
+	}
 }
 
 int main(void) {
-	// s
-	DDRB = 0xFF;
-	DDRC = 0x33; //0b0011 0011
-	DDRD = 0xFB; //PD2 ȊO͏o PD6Timer0Ő 0b1111 1011
-	PORTC = 0;
-	PORTD = 0;
-
-	// Timer2: d1000Hz
-	TCCR2A = (1<<WGM21);
-	TCCR2B = (1<<CS21);
-	OCR2A = (F_CPU/(8*1000)-1); // 1000Hz
-	TIMSK2 = (1<<OCIE2A);
-
-	// Timer1: 1msi1000Hzj
-	TCCR1A = 0;
-	TCCR1B = (1<<WGM12) | (1<<CS11); // CTC[hAvXP[8
-	OCR1A = (F_CPU/8/1000) - 1; // 1ms = 1000000/8/1000 = 124
-	TIMSK1 = (1<<OCIE1A);
-
-	// INT0: 1HzXV
-	EICRA = (1<<ISC01);
-	EIMSK = (1<<INT0);
-
-	// uU[i~ԁj
-	buzzer_stop();
-	
-	//ċNɃuU[炷(20ms1)
-	//buzzer_timer = 100;
+	// ピン、省電力、タイマー、INT0、ブザー（停止状態）の初期化
+	hal_init();
+	PROF_INIT(); // 計測自体の所要を実測（Timer1はhal_initで動作開始）
+
+#if UART_CONSOLE
+	uart_init();
+#endif
+
+	// フラグ初期値（GPIOR0/1はリセットで0）
+	FLAGS = F_BLINK_EN | F_BLINK;
+
+	// 保存済みの設定（EEPROMの連番だけを走査、なければ既定値）
+	settings_t set;
+	settings_load(&set);
+	settings_apply(&set);
+
+	//再起動時にブザーを鳴らす(20ms1回)
+	//buzzer_play(mel_beep2);
+
+	// 時刻が読めるまで「-- -- --」を表示（多重化は最初から動かす）
+	for (uint8_t i = 0; i < 7; i++) {
+		seg[i] = (i < 6) ? SEG_DASH : SEG_BLANK;
+		mux_render(i);
+	}
+	hal_mux_start();
 
 	// I2C & RTC
 	i2c_init();
 	
-	// bWX^i0x02jVLrbgmF
-	i2c_start(0xA2); // RTC݃AhX
-	i2c_send(0x02); // bWX^w
-	i2c_stop();
-	
-	i2c_start(0xA3); // RTCǂݏoAhX
-	uint8_t sec_data = i2c_recv(0); // bWX^ǂݏo
-	i2c_stop();
-	
-	if (sec_data & (1 << 7)) { // VLrbgibit7j1̏ꍇ
-		led7_always_on = 1; // LED7펞_
-		set_rtc_time(0, 0, 0); // 00:00:00ɐݒ
-		rtc_write_date(25, 1, 1); // N2025.01.01ɐݒ
-	}
+	hal_tick_start(); // I2Cのタイムアウト監視のためRTCアクセス前から動作
+	hal_irq_on(); // RTCアクセスはTWI割込みによる非同期転送
+
+	// 全レジスタ（0x00?0x0F）を1バーストで読み出し（起動時の読み出しはこの1回のみ）
+	rtc_sync(RTC_CTRL1, RTC_TIMER, 0);
+	rtc_wait();
 	
-	// 0DWX^ǂݏoA}XN
-	uint8_t reg0D = rtc_read_reg0D() & 0x83; // 0x83Ń}XN
+	// 以降のRTC書き込みは待たずにバックグラウンドで送る（シャドウには即時反映）
+	// 0Dレジスタをマスク処理
+	uint8_t reg0D = rtc_reg[RTC_CLKOUT] & 0x83; // 0x83でマスク
 	if (reg0D == 0x80) { // FD1=0, FD0=0, FE=1
 		rtc_init_full();
-		buzzer_timer = 20;	//d20ms̃uU[炷
+		buzzer_play(mel_beep1);	//初期電源投入時20msのブザーを鳴らす
 		} else if(reg0D == 0x83){
-		buzzer_timer = 100;	//d20ms 2̃uU[炷
+		rtc_write(RTC_CTRL2, RTC_CTRL2_RUN); // AF/TFクリア、アラーム割込み有効
+		rtc_flush();
+		buzzer_play(mel_beep2);	//電源投入時に20ms 2回のブザーを鳴らす
 		} else {
 		// CLKOUT Frequency
-		i2c_start(0xA2);
-		i2c_send(0x0D);
-		i2c_send(0x83); //FE=1,1Hz
-		i2c_stop();
-		buzzer_timer = 20;
+		rtc_write(RTC_CLKOUT, 0x83); //FE=1,1Hz
+		rtc_write(RTC_CTRL2, RTC_CTRL2_RUN); // AF/TFクリア、アラーム割込み有効
+		rtc_flush();
+		buzzer_play(mel_beep1);
 	}
-	_delay_ms(1);
 	
-	process_rtc_update();
-	sei();
+	if (rtc_reg[RTC_SEC] & RTC_VL) { // VLビット（bit7）が1の場合
+		set_rtc_time(0x00, 0x00, 0x00); // 時刻を00:00:00に設定
+		rtc_write_date(0x25, 0x01, 0x01); // 年月日を2025.01.01に設定
+		CONF |= C_LED7_ON; // LED7を常時点灯（時刻再設定まで）
+	}
+	rtc_load_time();
+	rtc_load_date();
+	bright_update(); // 時刻が決まってから夜間の輝度を判定
+	render_update(); // 最初の有効表示
+	PROF_BOOT();
+
+	bcdtime_t now;
+	clock_get(&now);
+	alarm_load(now.hour, now.min); // 次のアラーム（時報）をRTCに設定
+
+	// スイッチ処理開始
+	input_init();
+	timer_start(&blink_tmr, BLINK_CYCLES, BLINK_CYCLES); // 0.25s (4Hz)
 
 	while (1) {
-		if (rtc_update_flag && mode == MODE_NORMAL) { // ݒ胂[hRTCǂݍݒ~
-			rtc_update_flag = 0;
-			process_rtc_update();
+		// 処理すべきイベントがなければ割込みまでアイドルスリープ
+		hal_irq_off();
+		if (!event_pending() && !((FLAGS & F_RESYNC) && mode == MODE_NORMAL)) {
+			FLAGS |= F_IDLE;
+			hal_idle(); // 割込み判定とスリープの間でイベントを取りこぼさない
+			FLAGS &= ~F_IDLE;
+		}
+		hal_irq_on();
+
+		uint8_t ev, handled = 0;
+		while ((ev = event_get()) != EVT_NONE) {
+			dispatch(ev);
+			handled = 1;
+		}
+		if (handled) render_update(); // 変化した桁のみ描画
+
+		// 一定間隔および設定保存後にRTCへ再同期
+		if ((FLAGS & F_RESYNC) && mode == MODE_NORMAL && process_rtc_update() == 0) {
+			FLAGS &= ~F_RESYNC;
+			resync_timer = 0;
 		}
 	}
 }
\ No newline at end of file
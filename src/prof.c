@@ -0,0 +1,79 @@
+#include <avr/io.h>
+#include <util/atomic.h>
+#include <avr/pgmspace.h>
+#include "prof.h"
+
+#if PROF_STATS
+
+// Timer1（CTC、1ms周期）のカウンタと1ms回数を合わせて時刻とする
+prof_stats_t prof;
+static volatile uint32_t prof_ms;
+static uint16_t prof_bias; // 計測区間に含まれるprof_now自体の所要
+
+// サイクル予算（Timer1カウント）
+#define BUDGET(c) (((c) / T1_DIV) > 0xFFFF ? 0xFFFF : (c) / T1_DIV)
+static const uint16_t budget[PROF_NUM] PROGMEM = {
+	BUDGET(PROF_BUDGET_T1), BUDGET(PROF_BUDGET_T2), BUDGET(PROF_BUDGET_INT0), BUDGET(PROF_BUDGET_I2C)
+};
+
+// 現在時刻（Timer1カウント、割込み内か割込み禁止中に呼ぶ）
+uint32_t prof_now(void) {
+	uint16_t c = TCNT1;
+	uint32_t ms = prof_ms;
+	// 比較一致済みでTimer1割込みが未処理なら1周期分進める
+	if ((TIFR1 & (1 << OCF1A)) && c < T1_OCR / 2) ms++;
+	return ms * (T1_OCR + 1) + c;
+}
+
+// 計測値の記録
+void prof_add(uint8_t id, uint32_t d) {
+	prof_slot_t *s = &prof.slot[id];
+	d = (d > prof_bias) ? d - prof_bias : 0;
+	uint16_t c = (d > 0xFFFF) ? 0xFFFF : d;
+
+	if (s->n == 0) {
+		s->min = s->max = s->avg = c;
+	} else {
+		if (c < s->min) s->min = c;
+		if (c > s->max) s->max = c;
+		s->avg = (uint16_t)(s->avg + ((int32_t)c - s->avg) / 16);
+	}
+	if (s->n != 0xFFFF) s->n++;
+	if (c > pgm_read_word(&budget[id]) && s->over != 0xFFFF) s->over++;
+}
+
+// Timer1割込みの先頭で呼ぶ：時刻を進め、割込み遅延を記録
+void prof_tick(void) {
+	uint16_t lat = TCNT1; // CTCで0に戻ってからの経過
+	prof_ms++;
+	if (lat > prof.t1_latency) prof.t1_latency = lat;
+}
+
+// 計測自体の所要を実測（起動時、Timer1動作後・割込み許可前に呼ぶ）
+// PROF_ENTER～PROF_EXITの区間には前のprof_nowのTCNT1読み出し後と次のprof_nowの読み出し前が入る
+// 連続した2回の差がちょうどその分になる
+void prof_calibrate(void) {
+	uint32_t t0 = prof_now();
+	PROF_PIN_HI();
+	uint32_t t1 = prof_now();
+	PROF_PIN_LO();
+	prof_bias = t1 - t0;
+}
+
+// 最初の有効表示の時刻を記録（メインループに入る前）
+// prof_msは割込み許可後のTimer1割込みから数えるため、値は割込み許可からの経過になる
+void prof_boot(void) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		prof.boot = prof_now();
+	}
+}
+
+// 統計のクリア（メインループから）
+void prof_reset(void) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		uint8_t *p = (uint8_t *)&prof;
+		for (uint8_t i = 0; i < sizeof(prof); i++) p[i] = 0;
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include "config.h"
+#include "rtc.h"
+
+// 割込み・I2C転送の所要時間計測（1で有効、0ではコードもRAMも使わない）
+#ifndef PROF_STATS
+#define PROF_STATS 0
+#endif
+// 計測ピン（1で計測区間中PD3をHIGH、オシロスコープ観測用、PROF_STATS=1が必要）
+#ifndef PROF_PIN
+#define PROF_PIN   0
+#endif
+
+// 計測項目
+#define PROF_T1    0 // TIMER1_COMPA_vect
+#define PROF_T2    1 // TIMER2_COMPA_vect
+#define PROF_INT0  2 // INT0_vect
+#define PROF_I2C   3 // I2C転送1件（開始から完了まで、再試行を含む）
+#define PROF_NUM   4
+
+// サイクル予算（これを超えた回数をoverに数える）
+// 計測値は区間内のprof_now自体の所要（32bit乗算と呼び出し、起動時にprof_calibrateで実測）を差し引いた値
+// Timer2の予算は約89サイクル（1MHz）で、計測の所要を含めると毎回超過してしまうため
+#define PROF_BUDGET_T1   (F_CPU / TICK_HZ * 2 / 5)               // 1ms周期の40%
+#define PROF_BUDGET_T2   (F_CPU / MUX_SLOT_HZ / 8)               // 多重化スロット周期の12.5%
+#define PROF_BUDGET_INT0 (F_CPU / 2000)                          // 0.5ms
+#define PROF_BUDGET_I2C  (F_CPU / I2C_SCL_HZ * 9 * (RTC_NREG + 3) * 2) // 最長バースト（19バイト）の2倍
+
+// 単位はTimer1のカウント（サイクル数 = カウント×T1_DIV）、計測の所要は差し引き済み
+typedef struct {
+	uint16_t min, max; // 最小/最大
+	uint16_t avg;      // 平均（指数移動平均、重み1/16）
+	uint16_t n;        // 回数（65535で飽和）
+	uint16_t over;     // 予算超過回数（65535で飽和）
+} prof_slot_t;
+
+typedef struct {
+	prof_slot_t slot[PROF_NUM];
+	uint16_t t1_missed;  // Timer1割込みが次の1msまでに終わらなかった回数
+	uint16_t t2_missed;  // Timer2割込みが次のスロットまでに終わらなかった回数
+	uint16_t t1_latency; // Timer1比較一致から割込み処理開始までの最大カウント
+	uint32_t boot;       // 割込み許可（hal_tick_start後のsei）から最初の有効表示までのカウント
+	                     // Timer1割込みが動く前（リセット～hal_init、settings_load、i2c_init）は含まない
+	                     // 起点はその直前のTimer1の周期境界（1ms以内の誤差）
+} prof_stats_t;
+
+#define PROF_CYCLES(c) ((uint32_t)(c) * T1_DIV)
+
+#if PROF_STATS
+extern prof_stats_t prof;
+extern uint32_t prof_now(void);
+extern void prof_add(uint8_t id, uint32_t d);
+extern void prof_tick(void);
+extern void prof_reset(void);
+extern void prof_boot(void);
+extern void prof_calibrate(void);
+
+#if PROF_PIN
+#define PROF_PD          (1 << PD3) // 多重化のPORTD書き込みでも維持する
+#define PROF_PIN_HI()    (PORTD |= PROF_PD)
+#define PROF_PIN_LO()    (PORTD &= ~PROF_PD)
+#else
+#define PROF_PD          0
+#define PROF_PIN_HI()
+#define PROF_PIN_LO()
+#endif
+
+#define PROF_ENTER()     uint32_t prof_t0_ = prof_now(); PROF_PIN_HI()
+#define PROF_EXIT(id)    do { prof_add((id), prof_now() - prof_t0_); PROF_PIN_LO(); } while (0)
+#define PROF_START(t)    ((t) = prof_now())
+#define PROF_END(id, t)  prof_add((id), prof_now() - (t))
+#define PROF_TICK()      prof_tick()
+#define PROF_BOOT()      prof_boot()
+#define PROF_INIT()      prof_calibrate()
+#define PROF_MISSED(cond, cnt) do { if ((cond) && (cnt) != 0xFFFF) (cnt)++; } while (0)
+#else
+#define PROF_PD          0
+#define PROF_ENTER()
+#define PROF_EXIT(id)
+#define PROF_START(t)
+#define PROF_END(id, t)
+#define PROF_TICK()
+#define PROF_BOOT()
+#define PROF_INIT()
+#define PROF_MISSED(cond, cnt)
+#endif
+
+#endif
\ No newline at end of file
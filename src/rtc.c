@@ -0,0 +1,117 @@
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "hal.h"
+#include "i2c.h"
+#include "rtc.h"
+
+#define RTC_WR_SLOTS 3 // 同時に投入できる書き込みバースト数
+
+uint8_t rtc_reg[RTC_NREG];            // シャドウレジスタ
+static uint8_t rx_buf[RTC_NREG];      // 読み出しバッファ
+static uint8_t tx_buf[RTC_NREG];      // 書き込みバッファ（レジスタ番号で対応）
+static volatile uint16_t dirty;       // 未書き込みレジスタ
+static volatile uint16_t pending;     // 書き込み転送中レジスタ
+static void (*sync_done)(void);       // 一括読み出し完了通知
+
+static void rd_done(i2c_xfer_t *x);
+static void wr_done(i2c_xfer_t *x);
+static i2c_xfer_t rd = { RTC_ADR, 0, I2C_READ, 0, 0, rd_done, I2C_DONE };
+static i2c_xfer_t wr[RTC_WR_SLOTS] = {
+	{ RTC_ADR, 0, I2C_WRITE, 0, 0, wr_done, I2C_DONE },
+	{ RTC_ADR, 0, I2C_WRITE, 0, 0, wr_done, I2C_DONE },
+	{ RTC_ADR, 0, I2C_WRITE, 0, 0, wr_done, I2C_DONE }
+};
+
+// レジスタfirstからlen個分のビットマスク
+static uint16_t range_mask(uint8_t first, uint8_t len) {
+	return (uint16_t)(((1UL << len) - 1) << first);
+}
+
+// レジスタfirst?lastをリピートスタート付き自動インクリメントで一括読み出し（非同期）
+int rtc_sync(uint8_t first, uint8_t last, void (*done)(void)) {
+	if (rd.status == I2C_BUSY) return -1;
+	rd.reg = first;
+	rd.len = last - first + 1;
+	rd.buf = &rx_buf[first];
+	sync_done = done;
+	return i2c_submit(&rd);
+}
+
+// 読み出し完了：書き込み待ちのレジスタ以外をシャドウへ反映
+static void rd_done(i2c_xfer_t *x) {
+	if (x->status != I2C_DONE) return;
+	uint16_t keep = dirty | pending;
+	for (uint8_t i = 0; i < x->len; i++) {
+		uint8_t r = x->reg + i;
+		if (!(keep & (1U << r))) rtc_reg[r] = rx_buf[r];
+	}
+	if (sync_done) sync_done();
+}
+
+// シャドウを更新し書き込み対象に登録（rtc_flushで送信）
+void rtc_write(uint8_t reg, uint8_t val) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		rtc_reg[reg] = val;
+		dirty |= 1U << reg;
+	}
+}
+
+// 未書き込みレジスタを連続範囲ごとのバーストにまとめて送信（非同期）
+// 転送中のレジスタは完了後に送る（同一レジスタへの書き込み順序を保つ）
+void rtc_flush(void) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		uint8_t r = 0;
+		while (r < RTC_NREG) { // 最後の範囲が0x0Fで終わるとr=16（16bitのシフト幅を超える）
+			uint16_t ready = (dirty & ~pending) >> r;
+			if (!ready) break;
+			while (!(ready & 1)) {
+				ready >>= 1;
+				r++;
+			}
+
+			uint8_t len = 0;
+			while (ready & 1) {
+				tx_buf[r + len] = rtc_reg[r + len];
+				ready >>= 1;
+				len++;
+			}
+
+			i2c_xfer_t *x = 0;
+			for (uint8_t i = 0; i < RTC_WR_SLOTS; i++) {
+				if (wr[i].status != I2C_BUSY) x = &wr[i];
+			}
+			if (!x) break; // 空きなし：書き込み完了時に続きを送る
+
+			x->reg = r;
+			x->len = len;
+			x->buf = &tx_buf[r];
+			if (i2c_submit(x) != 0) break;
+			dirty &= ~range_mask(r, len);
+			pending |= range_mask(r, len);
+			r += len;
+		}
+	}
+}
+
+// 書き込み完了：残りがあれば続けて送信
+static void wr_done(i2c_xfer_t *x) {
+	pending &= ~range_mask(x->reg, x->len); // 失敗時も破棄（次回の同期で実値に戻る）
+	if (dirty) rtc_flush();
+}
+
+// 転送中または未書き込みのレジスタがあるか
+uint8_t rtc_busy(void) {
+	return rd.status == I2C_BUSY || dirty || pending;
+}
+
+// 全転送の完了待ち（メインコンテキスト専用、割込み許可後に呼ぶ）
+// 待つ間はアイドルスリープ（完了のTWI割込みで起きる、判定とスリープの間で取りこぼさない）
+void rtc_wait(void) {
+	for (;;) {
+		if (dirty && !pending) rtc_flush();
+		hal_irq_off();
+		if (!rtc_busy()) break;
+		hal_idle();
+	}
+	hal_irq_on();
+}
\ No newline at end of file
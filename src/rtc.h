@@ -0,0 +1,45 @@
+#ifndef RTC_H
+#define RTC_H
+
+#include <stdint.h>
+
+// RTC-8564 レジスタマップ
+#define RTC_ADR      0xA2
+#define RTC_CTRL1    0x00 // Control1（STOP, TEST）
+#define RTC_CTRL2    0x01 // Control2（TI/TP, AF, TF, AIE, TIE）
+#define RTC_SEC      0x02 // 秒（bit7: VL）
+#define RTC_MIN      0x03
+#define RTC_HOUR     0x04
+#define RTC_DAY      0x05
+#define RTC_WDAY     0x06
+#define RTC_MONTH    0x07 // 月（bit7: century）
+#define RTC_YEAR     0x08
+#define RTC_MIN_AL   0x09 // 分アラーム（bit7: AE）
+#define RTC_HOUR_AL  0x0A
+#define RTC_DAY_AL   0x0B
+#define RTC_WDAY_AL  0x0C
+#define RTC_CLKOUT   0x0D // CLKOUT（FE, FD1, FD0）
+#define RTC_TCTRL    0x0E // タイマー制御（TE, TD1, TD0）
+#define RTC_TIMER    0x0F // タイマー値
+#define RTC_NREG     16
+
+#define RTC_VL       (1<<7) // 秒レジスタの電圧低下ビット
+#define RTC_AE       (1<<7) // アラームレジスタの無効ビット
+
+// Control2 ビット
+#define RTC_TITP     (1<<4) // /INT パルス出力（タイマー）
+#define RTC_AF       (1<<3) // アラームフラグ（0書き込みでクリア）
+#define RTC_TF       (1<<2) // タイマーフラグ
+#define RTC_AIE      (1<<1) // アラーム割込み有効
+#define RTC_TIE      (1<<0) // タイマー割込み有効
+#define RTC_CTRL2_RUN (RTC_TITP | RTC_AIE | RTC_TIE) // 通常動作値（AF/TFクリア）
+
+extern uint8_t rtc_reg[RTC_NREG]; // シャドウレジスタ（最後に読んだ/書いた値）
+
+extern int rtc_sync(uint8_t first, uint8_t last, void (*done)(void));
+extern void rtc_write(uint8_t reg, uint8_t val);
+extern void rtc_flush(void);
+extern uint8_t rtc_busy(void);
+extern void rtc_wait(void);
+
+#endif
\ No newline at end of file
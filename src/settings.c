@@ -0,0 +1,117 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+#include "common.h"
+#include "settings.h"
+
+#if SET_SLOTS * SET_REC_LEN > E2END + 1
+#error "settings ring does not fit in EEPROM"
+#endif
+
+// レコード：{データ14, CRC8, 連番}
+// 連番は最後に書くため、書き込み途中の電源断ではそのスロットに前周回の連番が残り最新とみなされない
+// CRCはデータと連番が対象（消去状態の全0xFFは不一致になる）
+#define REC_CRC  SET_DATA_LEN
+#define REC_SEQ  (SET_DATA_LEN + 1)
+#define rec_adr(n, i) ((uint16_t)(n) * SET_REC_LEN + (i))
+
+static uint8_t rec[SET_REC_LEN];                // 最新レコード（書き込み中はEE_READY割込みが送出）
+static uint8_t slot;                             // 最新レコードのスロット（次はこの次に書く）
+static volatile uint8_t wr_idx = SET_REC_LEN;   // 書き込み中のバイト位置（SET_REC_LENで停止）
+
+// 既定値（有効なレコードがないとき）
+static const settings_t def PROGMEM = { SET_24H, {{0}}, 0x50, {0x22, 0x06}, {0, 0} }; // 22時～6時は5段減光
+
+// 1バイト読み出し（起動時のみ、リセット前の書き込みが残っていれば完了を待つ）
+static uint8_t ee_read(uint16_t adr) {
+	while (EECR & (1 << EEPE));
+	EEAR = adr;
+	EECR |= (1 << EERE);
+	return EEDR;
+}
+
+static uint8_t rec_crc(const uint8_t *r) {
+	uint8_t c = 0;
+	for (uint8_t i = 0; i < SET_REC_LEN; i++) {
+		if (i != REC_CRC) c = _crc8_ccitt_update(c, r[i]);
+	}
+	return c;
+}
+
+// 起動時の読み出し（割込み許可前に呼ぶ）
+// 連番だけを走査して切れ目の直前を最新とし、CRC不一致なら古い方へ遡る
+// 有効なレコードがあれば1、なければ既定値で0
+uint8_t settings_load(settings_t *s) {
+	uint8_t prev = ee_read(rec_adr(SET_SLOTS - 1, REC_SEQ));
+	slot = SET_SLOTS - 1;
+	for (uint8_t n = 0; n < SET_SLOTS; n++) {
+		uint8_t q = ee_read(rec_adr(n, REC_SEQ));
+		if (q != (uint8_t)(prev + 1)) { // 32スロットの連番は一周しないので必ず切れ目がある
+			slot = (n + SET_SLOTS - 1) % SET_SLOTS;
+			break;
+		}
+		prev = q;
+	}
+	uint8_t seq = ee_read(rec_adr(slot, REC_SEQ));
+
+	uint8_t *d = (uint8_t *)s;
+	for (uint8_t k = 0, n = slot; k < SET_SLOTS; k++, n = (n + SET_SLOTS - 1) % SET_SLOTS) {
+		for (uint8_t i = 0; i < SET_REC_LEN; i++) rec[i] = ee_read(rec_adr(n, i));
+		if (rec_crc(rec) == rec[REC_CRC]) {
+			for (uint8_t i = 0; i < SET_DATA_LEN; i++) d[i] = rec[i];
+			rec[REC_SEQ] = seq; // 次の連番は切れ目から続ける（遡った分を上書きしない）
+			return 1;
+		}
+	}
+	for (uint8_t i = 0; i < SET_DATA_LEN; i++) rec[i] = d[i] = pgm_read_byte((const uint8_t *)&def + i);
+	rec[REC_SEQ] = seq;
+	return 0;
+}
+
+// 保存（ブロックしない、EE_READY割込みで1バイトずつ書き込む）
+// 最新レコードと同じ内容なら書かない。書き込み中なら0（呼び出し側で再試行）
+uint8_t settings_save(const settings_t *s) {
+	const uint8_t *d = (const uint8_t *)s;
+	uint8_t same = 1;
+
+	if (wr_idx < SET_REC_LEN) return 0;
+	for (uint8_t i = 0; i < SET_DATA_LEN; i++) {
+		if (rec[i] != d[i]) same = 0;
+		rec[i] = d[i];
+	}
+	if (same) return 1;
+
+	slot = (slot + 1) % SET_SLOTS;
+	rec[REC_SEQ]++;
+	rec[REC_CRC] = rec_crc(rec);
+	barrier(); // レコードを作ってから開始
+	wr_idx = 0;
+	EECR |= (1 << EERIE);
+	return 1;
+}
+
+// 書き込み中か
+uint8_t settings_busy(void) {
+	return wr_idx < SET_REC_LEN;
+}
+
+// EEPROM書き込み完了ごとに次のバイト（同じ値のバイトは消去・書き込みしない）
+ISR(EE_READY_vect) {
+	uint8_t i = wr_idx;
+	while (i < SET_REC_LEN) {
+		uint8_t b = rec[i];
+		EEAR = rec_adr(slot, i);
+		EECR |= (1 << EERE);
+		i++;
+		if (EEDR != b) {
+			EEDR = b;
+			EECR |= (1 << EEMPE);
+			EECR |= (1 << EEPE); // EEMPEから4サイクル以内
+			wr_idx = i;
+			return;
+		}
+	}
+	wr_idx = i;
+	EECR &= ~(1 << EERIE);
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+
+// 設定のEEPROM保存（512バイトを16バイトのレコード×32スロットのリングとして追記）
+// 書き換え寿命：1セル10万回×32スロット＝約320万回の保存
+//   保存は最後の変更からSAVE_DELAY_MS（main.c）後にまとめて1回、内容が同じなら書かない
+//   10秒ごとに変更し続けても約1年、1日10回の変更なら800年以上
+#define SET_REC_LEN   16
+#define SET_SLOTS     32
+#define SET_DATA_LEN  14 // レコードのデータ部（残りはCRC8と連番）
+
+#define SET_24H       (1<<0) // flags：24時間表記
+#define SET_AL_EN     (1<<7) // alarm[][0]：有効（下位は時のBCD）
+
+typedef struct {
+	uint8_t flags;       // SET_xxx
+	uint8_t alarm[4][2]; // ユーザーアラーム {時（bit7:有効）, 分}（BCD）
+	uint8_t dim;         // 減光段数（下位4bit:昼、上位4bit:夜、0で最大輝度）
+	uint8_t night[2];    // 夜間の時間帯 {開始時, 終了時}（BCD、同じなら夜間なし）
+	uint8_t trim[2];     // 桁ごとの減光（2bit×7スロット、trim[0]の下位がスロット0）
+} settings_t;
+
+extern uint8_t settings_load(settings_t *s);
+extern uint8_t settings_save(const settings_t *s);
+extern uint8_t settings_busy(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "stopwatch.h"
+
+#define SW_RENDER_MS 10 // 表示更新の間隔（1/100秒）
+
+static volatile uint16_t phase;    // 前回のINT0からの経過ms（999で止める、割込み内のみ更新）
+static volatile uint16_t run_sec;  // 開始からのINT0回数
+static volatile uint8_t running;
+static uint8_t render_div;         // 表示更新の分周（Timer1割込み内のみ）
+static uint16_t start_phase;       // 開始時のphase
+static sw_time_t acc;              // 停止までに積算した時間（メインループのみ）
+
+// RTCの1秒（INT0割込みから）
+void sw_int0(void) {
+	phase = 0;
+	if (running) run_sec++;
+}
+
+// 1ms（Timer1割込みから）、動作中は10msごとに1を返す（再描画要求）
+// RCが速く1秒内に1000msを超えても補間は999msで止まり、次のINT0で揃う
+uint8_t sw_tick(void) {
+	if (phase < 999) phase++;
+	if (!running) return 0;
+	if (++render_div < SW_RENDER_MS) return 0;
+	render_div = 0;
+	return 1;
+}
+
+// 開始（メインループから）
+void sw_start(void) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		start_phase = phase;
+		run_sec = 0;
+		render_div = 0;
+		running = 1;
+	}
+}
+
+// 経過時間（積算分＋動作中の区間）
+void sw_get(sw_time_t *t) {
+	uint16_t s, p, p0;
+	uint8_t r;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		s = run_sec;
+		p = phase;
+		p0 = start_phase;
+		r = running;
+	}
+	t->sec = acc.sec;
+	t->ms = acc.ms;
+	if (!r) return;
+
+	// 区間 = s秒 + (p - p0)ms（開始直後のINT0前はs=0かつp>=p0）
+	if (p < p0) {
+		s--;
+		p += 1000;
+	}
+	t->ms += p - p0;
+	t->sec += s;
+	if (t->ms >= 1000) {
+		t->ms -= 1000;
+		t->sec++;
+	}
+}
+
+// 停止：ここまでの時間を積算
+void sw_stop(void) {
+	sw_time_t t;
+	sw_get(&t);
+	running = 0;
+	acc = t;
+}
+
+// ゼロに戻す（停止中に呼ぶ）
+void sw_reset(void) {
+	running = 0;
+	acc.sec = 0;
+	acc.ms = 0;
+}
+
+uint8_t sw_running(void) {
+	return running;
+}
\ No newline at end of file
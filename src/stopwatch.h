@@ -0,0 +1,24 @@
+#ifndef STOPWATCH_H
+#define STOPWATCH_H
+
+#include <stdint.h>
+
+// ストップウォッチ（1/100秒表示）
+// 秒はRTCの1Hz（INT0）で数え、1秒未満だけTimer1の1msで補間する
+// 内部RC発振の誤差や割込み負荷で長時間の計測がずれない（誤差はRTCの水晶のみ）
+typedef struct {
+	uint16_t sec; // 秒
+	uint16_t ms;  // 1秒未満（0?999）
+} sw_time_t;
+
+#define SW_MAX_SEC  5999 // 99:59.99
+
+extern void sw_int0(void);
+extern uint8_t sw_tick(void);
+extern void sw_start(void);
+extern void sw_stop(void);
+extern void sw_reset(void);
+extern void sw_get(sw_time_t *t);
+extern uint8_t sw_running(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "timer.h"
+
+static swtimer_t *head; // 満了順に並んだ差分リスト
+
+// 差分リストへ挿入（割込み禁止で呼ぶ）
+static void insert(swtimer_t *t, uint16_t ms) {
+	swtimer_t **pp = &head;
+
+	while (*pp && (*pp)->delta <= ms) {
+		ms -= (*pp)->delta;
+		pp = &(*pp)->next;
+	}
+	if (*pp) (*pp)->delta -= ms; // 後続の差分を詰める
+	t->delta = ms;
+	t->next = *pp;
+	t->active = 1;
+	*pp = t;
+}
+
+// 差分リストから削除（割込み禁止で呼ぶ）
+static void detach(swtimer_t *t) {
+	swtimer_t **pp = &head;
+
+	while (*pp && *pp != t) pp = &(*pp)->next;
+	if (!*pp) return;
+	if (t->next) t->next->delta += t->delta; // 差分を後続へ引き継ぐ
+	*pp = t->next;
+	t->active = 0;
+}
+
+// タイマー開始（ms後に満了、period>0なら以後period毎に満了）。動作中なら再スタート
+void timer_start(swtimer_t *t, uint16_t ms, uint16_t period) {
+	if (ms == 0) ms = 1;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (t->active) detach(t);
+		t->period = period;
+		insert(t, ms);
+	}
+}
+
+// タイマー停止
+void timer_stop(swtimer_t *t) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (t->active) detach(t);
+	}
+}
+
+// 1msティック（Timer1割込みから呼ぶ）：先頭の差分を減らし満了分のみ処理
+void timer_tick(void) {
+	if (!head) return;
+	head->delta--;
+	while (head && head->delta == 0) {
+		swtimer_t *t = head;
+		head = t->next;
+		t->active = 0;
+		if (t->period) insert(t, t->period); // 満了時刻基準で再登録（ドリフトなし）
+		if (t->cb) t->cb();
+	}
+}
\ No newline at end of file
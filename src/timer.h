@@ -0,0 +1,23 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+// ソフトウェアタイマー（1ms単位、差分リストで管理）
+typedef struct swtimer {
+	struct swtimer *next;   // 次のタイマー
+	uint16_t delta;         // 前のタイマーからの差分（ms）
+	uint16_t period;        // 周期（ms、0でワンショット）
+	uint8_t active;         // リスト登録中
+	void (*cb)(void);       // 満了コールバック（Timer1割込み内で呼ばれる、NULL可）
+} swtimer_t;
+
+#define SWTIMER(cb) { 0, 0, 0, 0, (cb) }
+
+extern void timer_start(swtimer_t *t, uint16_t ms, uint16_t period);
+extern void timer_stop(swtimer_t *t);
+extern void timer_tick(void);
+
+#define timer_active(t) ((t)->active)
+
+#endif
\ No newline at end of file
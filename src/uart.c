@@ -0,0 +1,117 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "config.h"
+#include "common.h"
+#include "event.h"
+#include "uart.h"
+
+#if UART_CONSOLE
+
+// 受信・送信とも単一生産者・単一消費者リング（ロックなし）
+// 受信：生産者はUSART_RX割込み、消費者はメインループ
+// 送信：生産者はメインループ、消費者はUSART_UDRE割込み（満杯なら捨てて待たない）
+static uint8_t rx_buf[UART_RX_LEN];
+static volatile uint8_t rx_head, rx_tail;
+static uint8_t tx_buf[UART_TX_LEN];
+static volatile uint8_t tx_head, tx_tail;
+volatile uart_err_t uart_err;
+
+// USART0初期化（8N1、倍速モード、受信割込み有効）
+void uart_init(void) {
+	PRR &= ~(1 << PRUSART0);
+	UBRR0 = UART_UBRR;
+	UCSR0A = (1 << U2X0);
+	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+	UCSR0B = (1 << RXCIE0) | (1 << RXEN0) | (1 << TXEN0);
+}
+
+// 受信：リングに積み、行末（CR/LF）でメインループへ通知
+ISR(USART_RX_vect) {
+	uint8_t st = UCSR0A;
+	uint8_t c = UDR0;
+	if (st & ((1 << FE0) | (1 << DOR0))) err_inc(uart_err.rx_err);
+
+	uint8_t h = rx_head;
+	uint8_t next = (h + 1) & (UART_RX_LEN - 1);
+	if (next == rx_tail) {
+		err_inc(uart_err.rx_lost);
+		if (c == '\r' || c == '\n') event_post(EVT_UART); // 行末のない満杯を捨てさせる
+		return;
+	}
+	rx_buf[h] = c;
+	barrier();
+	rx_head = next;
+	if (c == '\r' || c == '\n') event_post(EVT_UART);
+}
+
+// 送信：リングから1文字、空になったら割込み停止
+ISR(USART_UDRE_vect) {
+	uint8_t t = tx_tail;
+	if (t == tx_head) {
+		UCSR0B &= ~(1 << UDRIE0);
+		return;
+	}
+	UDR0 = tx_buf[t];
+	tx_tail = (t + 1) & (UART_TX_LEN - 1);
+}
+
+// 1行取り出し（メインループ、bufはUART_LINE_LEN）
+// 行末まで受信済みなら終端を除いた長さを返しNUL終端、未着なら何も取り出さず0
+uint8_t uart_getline(char *buf) {
+	uint8_t t = rx_tail, h = rx_head, n = 0;
+	for (;;) {
+		if (t == h) { // 行末未着
+			if (((h + 1) & (UART_RX_LEN - 1)) == rx_tail) rx_tail = h; // 満杯なら長すぎる行として破棄
+			return 0;
+		}
+		char c = rx_buf[t];
+		t = (t + 1) & (UART_RX_LEN - 1);
+		if (c == '\r' || c == '\n') break;
+		if (n < UART_LINE_LEN - 1) buf[n++] = c;
+	}
+	barrier();
+	rx_tail = t;
+	buf[n] = 0;
+	return n;
+}
+
+// 送信リングの空き
+uint8_t uart_room(void) {
+	return (tx_tail - tx_head - 1) & (UART_TX_LEN - 1);
+}
+
+// 1文字送信（メインループ、ブロックしない）
+void uart_putc(char c) {
+	uint8_t h = tx_head;
+	uint8_t next = (h + 1) & (UART_TX_LEN - 1);
+	if (next == tx_tail) {
+		err_inc(uart_err.tx_lost);
+		return;
+	}
+	tx_buf[h] = c;
+	barrier();
+	tx_head = next;
+	UCSR0B |= (1 << UDRIE0); // 読み書きの間にUDRE割込みがクリアしても、データ追加後なので再設定で正しい
+}
+
+// フラッシュ上の文字列を送信
+void uart_puts_P(const char *s) {
+	char c;
+	while ((c = pgm_read_byte(s++))) uart_putc(c);
+}
+
+// 16進2桁
+void uart_hex8(uint8_t v) {
+	static const char hex[16] PROGMEM = "0123456789ABCDEF";
+	uart_putc(pgm_read_byte(&hex[v >> 4]));
+	uart_putc(pgm_read_byte(&hex[v & 0x0F]));
+}
+
+// 16進4桁
+void uart_hex16(uint16_t v) {
+	uart_hex8(v >> 8);
+	uart_hex8(v);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+#include <avr/io.h>
+
+// USART0コンソール（1で有効、0ではコードもRAMも使わない）
+// RXD/TXD（PD0/PD1）はCOM0/COM1と共用のため、有効時は秒の2桁を表示しない
+#ifndef UART_CONSOLE
+#define UART_CONSOLE 0
+#endif
+
+#define UART_RX_LEN   32  // 受信リング長（2のべき乗）
+#define UART_TX_LEN   128 // 送信リング長（2のべき乗）
+#define UART_LINE_LEN 24  // 1行の最大長（終端を含む、超えた分は捨てる）
+
+// 受信エラー・取りこぼし回数（255で飽和）
+typedef struct {
+	uint8_t rx_lost;  // 受信リング満杯で捨てた文字
+	uint8_t rx_err;   // フレーミングエラー・オーバーラン
+	uint8_t tx_lost;  // 送信リング満杯で捨てた文字
+} uart_err_t;
+
+#if UART_CONSOLE
+extern volatile uart_err_t uart_err;
+
+extern void uart_init(void);
+extern uint8_t uart_getline(char *buf);
+extern uint8_t uart_room(void);
+extern void uart_putc(char c);
+extern void uart_puts_P(const char *s);
+extern void uart_hex8(uint8_t v);
+extern void uart_hex16(uint16_t v);
+
+#define UART_PD (1 << PD0) // RXDのプルアップ（多重化のPORTD書き込みでも維持する）
+#else
+#define UART_PD 0
+#endif
+
+#endif
\ No newline at end of file
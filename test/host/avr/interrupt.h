@@ -0,0 +1,18 @@
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include <stdint.h>
+
+// ホスト用 <avr/interrupt.h>：割込みベクタは通常の関数、Iフラグはsim.cが持つ
+// 割込みはsim.cが時間を進めるとき（hal_idle、sim_run）にIフラグが1なら優先順に呼ばれる
+
+#define ISR(vector, ...) void vector(void); void vector(void)
+
+extern volatile uint8_t sim_sreg_i; // Iフラグ
+extern void sim_cli(void);
+extern void sim_sei(void);
+
+#define cli() sim_cli()
+#define sei() sim_sei()
+
+#endif
\ No newline at end of file
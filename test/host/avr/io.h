@@ -0,0 +1,110 @@
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+// ホスト用 <avr/io.h>（ATmega88Pのうちファームウェアが使うレジスタとビット）
+// レジスタは変数（実体はsim.c）。書き込みで動作が始まる周辺（TWI、EEPROM、USART0のUDR0、
+// SDA/SCLを駆動するDDRC）と計測で読むTCNT1はアクセスごとにsim_io()・sim_io16()を通し、モデルを進めてから値を返す
+// 書き込み1でクリアするフラグ（TIFRn、PCIFR、EIFR）はモデル内部で持ち、レジスタへの書き込みは無視する
+// （TIFR1/TIFR2の読み出しは未処理の比較一致を返す：計測の取りこぼし判定用）
+
+#define _BV(b) (1U << (b))
+
+extern volatile uint8_t *sim_io(volatile uint8_t *reg);
+extern volatile uint16_t *sim_io16(volatile uint16_t *reg);
+
+// レジスタ一覧（sim.cが同じ一覧で実体を定義する）
+#define SIM_REGS(R8, R16) \
+	R8(PORTB) R8(PORTC) R8(PORTD) R8(DDRB) R8(DDRD) R8(PINB) R8(PINC) R8(PIND) \
+	R8(TCCR0A) R8(TCCR0B) R8(OCR0A) R8(TCNT0) R8(TIMSK0) R8(TIFR0) \
+	R8(TCCR1A) R8(TCCR1B) R16(OCR1A) R16(io_TCNT1) R8(TIMSK1) R8(io_TIFR1) \
+	R8(TCCR2A) R8(TCCR2B) R8(OCR2A) R8(OCR2B) R8(TCNT2) R8(TIMSK2) R8(io_TIFR2) \
+	R8(EICRA) R8(EIMSK) R8(EIFR) R8(PCICR) R8(PCMSK1) R8(PCIFR) \
+	R8(TWBR) R8(TWAR) \
+	R8(GPIOR0) R8(GPIOR1) R8(GPIOR2) R8(SMCR) R8(MCUSR) R8(PRR) R8(ACSR) \
+	R16(EEAR) \
+	R8(UCSR0A) R8(UCSR0B) R8(UCSR0C) R16(UBRR0) \
+	R8(io_DDRC) R8(io_TWCR) R8(io_TWSR) R8(io_TWDR) R8(io_EECR) R8(io_EEDR) R8(io_UDR0)
+
+#define SIM_EXTERN8(n)  extern volatile uint8_t n;
+#define SIM_EXTERN16(n) extern volatile uint16_t n;
+SIM_REGS(SIM_EXTERN8, SIM_EXTERN16)
+
+#define DDRC   (*sim_io(&io_DDRC))
+#define TWCR   (*sim_io(&io_TWCR))
+#define TWSR   (*sim_io(&io_TWSR))
+#define TWDR   (*sim_io(&io_TWDR))
+#define EECR   (*sim_io(&io_EECR))
+#define EEDR   (*sim_io(&io_EEDR))
+#define UDR0   (*sim_io(&io_UDR0))
+#define TCNT1  (*sim_io16(&io_TCNT1))
+#define TIFR1  (*sim_io(&io_TIFR1))
+#define TIFR2  (*sim_io(&io_TIFR2))
+
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define COM0A0 6
+#define WGM01 1
+#define WGM12 3
+#define WGM21 1
+#define OCIE1A 1
+#define OCF1A 1
+#define OCIE2A 1
+#define OCIE2B 2
+#define OCF2A 1
+#define OCF2B 2
+#define ISC01 1
+#define INT0 0
+#define PCIE1 1
+#define PCIF1 1
+#define PCINT10 2
+#define PCINT11 3
+
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC 3
+#define TWEN 2
+#define TWIE 0
+
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+
+#define RXC0 7
+#define UDRE0 5
+#define FE0 4
+#define DOR0 3
+#define U2X0 1
+#define RXCIE0 7
+#define UDRIE0 5
+#define RXEN0 4
+#define TXEN0 3
+#define UCSZ01 2
+#define UCSZ00 1
+
+#define PRTWI 7
+#define PRSPI 2
+#define PRUSART0 1
+#define PRADC 0
+#define ACD 7
+
+#define E2END 0x1FF
+
+#endif
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+#include <stdint.h>
+
+// ホスト用 <avr/pgmspace.h>：フラッシュとRAMの区別なし
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+
+#endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "config.h"
+#include "hal.h"
+#include "sim.h"
+
+// ホスト実装（hal_avr.cの差し替え）：レジスタにはhal_avr.cと同じ値を書き、sim.cのモデルが読む
+// スリープは次の割込みまでシミュレーション時間を進める。ブザーは発音の記録のみ
+
+void hal_init(void) {
+	DDRB = 0xFF;
+	DDRC = 0x03;
+	DDRD = 0xFB;
+	PORTC = 0;
+	PORTD = 0;
+	ACSR = (1<<ACD);
+	PRR = (1<<PRADC) | (1<<PRSPI) | (1<<PRUSART0);
+
+	TCCR2A = (1<<WGM21);
+	TCCR2B = T2_CS;
+	OCR2A = T2_OCR;
+	OCR2B = 0xFF;
+
+	TCCR1A = 0;
+	TCCR1B = (1<<WGM12) | T1_CS;
+	OCR1A = T1_OCR;
+
+	EICRA = (1<<ISC01);
+	EIMSK = (1<<INT0);
+
+	hal_buzzer_off();
+}
+
+void hal_tick_start(void) {
+	TIMSK1 = (1<<OCIE1A);
+}
+
+void hal_mux_start(void) {
+	TIMSK2 = (1<<OCIE2A) | (1<<OCIE2B);
+}
+
+void hal_sw_init(void) {
+	PCMSK1 = (1<<PCINT10) | (1<<PCINT11);
+	PCIFR = (1<<PCIF1);
+	PCICR |= (1<<PCIE1);
+}
+
+void hal_idle(void) {
+	sim_idle();
+}
+
+void hal_buzzer_tone(uint8_t ocr, uint8_t cs) {
+	TCCR0B = 0;
+	TCNT0 = 0;
+	OCR0A = ocr;
+	TCCR0A = (1 << COM0A0) | (1 << WGM01);
+	TCCR0B = cs;
+	sim_buzzer(ocr, cs);
+}
+
+void hal_buzzer_off(void) {
+	TCCR0A = 0;
+	TCCR0B = 0;
+	PORTD &= ~(1<<PD6);
+	sim_buzzer(0, 0);
+}
\ No newline at end of file
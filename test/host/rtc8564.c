@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include "sim.h"
+#include "rtc8564.h"
+
+// RTC-8564のモデル：秒の桁上がりはsim_atの事象（誤差はsim_cfg.rtc_ppm）、/INTはsim_int_lineへ
+
+#define CTRL1    0x00
+#define CTRL2    0x01
+#define SEC      0x02
+#define MIN      0x03
+#define HOUR     0x04
+#define DAY      0x05
+#define WDAY     0x06
+#define MONTH    0x07
+#define YEAR     0x08
+#define MIN_AL   0x09
+#define CLKOUT   0x0D
+#define TCTRL    0x0E
+#define TIMER    0x0F
+
+#define STOP     0x20
+#define TITP     0x10
+#define AF       0x08
+#define TF       0x04
+#define AIE      0x02
+#define TIE      0x01
+#define AE       0x80
+#define PULSE_PS (SIM_SEC / 64) // タイマーの/INTパルス幅（1Hzソース）
+
+uint8_t rtc8564_reg[16];
+uint32_t rtc8564_writes;
+
+// 書き込み可能なビット（未使用ビットは0で読める）
+static const uint8_t wmask[16] = {
+	0x28, 0x1F, 0xFF, 0x7F, 0x3F, 0x3F, 0x07, 0x9F,
+	0xFF, 0xFF, 0xBF, 0xBF, 0x87, 0x83, 0x83, 0xFF
+};
+
+static uint8_t ptr;         // レジスタポインタ
+static uint8_t addr_next;   // SLA+Wの次はレジスタ番号
+static uint8_t access;      // 転送中（時刻更新を保留）
+static uint8_t held;        // 保留中の秒数
+static uint8_t tcount;      // タイマーのカウンタ
+static uint8_t pulse;       // /INTパルス中
+
+static void second(void);
+static void pulse_end(void);
+
+static uint8_t bin(uint8_t v) {
+	return (v >> 4) * 10 + (v & 0x0F);
+}
+
+static uint8_t bcd(uint8_t v) {
+	return (uint8_t)(((v / 10) << 4) | (v % 10));
+}
+
+static uint8_t mdays(uint8_t m, uint8_t y) {
+	static const uint8_t d[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	return (m == 2 && y % 4 == 0) ? 29 : d[(m - 1) % 12];
+}
+
+static sim_time_t period(void) {
+	return (sim_time_t)(SIM_SEC / (1.0 + sim_cfg.rtc_ppm * 1e-6) + 0.5);
+}
+
+static void int_update(void) {
+	uint8_t c2 = rtc8564_reg[CTRL2];
+	uint8_t low = pulse || ((c2 & AF) && (c2 & AIE)) || ((c2 & TF) && (c2 & TIE) && !(c2 & TITP));
+	sim_int_line(!low);
+}
+
+// 1秒進める（秒→分→時→日→曜日→月→年→世紀）
+static void count(void) {
+	uint8_t *r = rtc8564_reg;
+	uint8_t s = bin(r[SEC] & 0x7F) + 1, mi = bin(r[MIN]), h = bin(r[HOUR]);
+	uint8_t d = bin(r[DAY]), mo = bin(r[MONTH] & 0x1F), y = bin(r[YEAR]);
+
+	if (s >= 60) {
+		s = 0;
+		if (++mi >= 60) {
+			mi = 0;
+			if (++h >= 24) {
+				h = 0;
+				r[WDAY] = (r[WDAY] + 1) % 7;
+				if (++d > mdays(mo, y)) {
+					d = 1;
+					if (++mo > 12) {
+						mo = 1;
+						if (++y > 99) {
+							y = 0;
+							r[MONTH] ^= 0x80;
+						}
+					}
+				}
+			}
+		}
+	}
+	r[SEC] = (r[SEC] & 0x80) | bcd(s);
+	r[MIN] = bcd(mi);
+	r[HOUR] = bcd(h);
+	r[DAY] = bcd(d);
+	r[MONTH] = (r[MONTH] & 0x80) | bcd(mo);
+	r[YEAR] = bcd(y);
+
+	// アラーム：分の桁上がりで、有効な（AE=0の）項目がすべて一致したらAF
+	if (s == 0) {
+		uint8_t any = 0, match = 1;
+		for (uint8_t i = 0; i < 4; i++) {
+			static const uint8_t reg[4] = {MIN, HOUR, DAY, WDAY};
+			uint8_t al = r[MIN_AL + i];
+			if (al & AE) continue;
+			any = 1;
+			if ((al & 0x7F) != r[reg[i]]) match = 0;
+		}
+		if (any && match) r[CTRL2] |= AF;
+	}
+
+	// 定周期タイマー（ソース1Hz：TD=10）
+	if ((r[TCTRL] & 0x80) && (r[TCTRL] & 0x03) == 0x02 && r[TIMER]) {
+		if (--tcount == 0) {
+			tcount = r[TIMER];
+			r[CTRL2] |= TF;
+			if (r[CTRL2] & TITP) {
+				pulse = (r[CTRL2] & TIE) != 0;
+				sim_at(sim_now + PULSE_PS, pulse_end);
+			}
+		}
+	}
+	int_update();
+}
+
+static void second(void) {
+	sim_at(sim_now + period(), second);
+	if (access) held++;
+	else count();
+}
+
+// パルス出力ではTFもパルス終了で戻る
+static void pulse_end(void) {
+	pulse = 0;
+	rtc8564_reg[CTRL2] &= ~TF;
+	int_update();
+}
+
+static void reg_write(uint8_t r, uint8_t v) {
+	uint8_t old = rtc8564_reg[r];
+	rtc8564_writes++;
+	v &= wmask[r];
+	if (r == CTRL2) v = (v & ~(AF | TF)) | (old & v & (AF | TF)); // AF/TFは0書き込みでのみクリア
+	rtc8564_reg[r] = v;
+	if (r == CTRL1 && ((old ^ v) & STOP)) {
+		// STOPで分周器をリセット：解除から1秒後に次の桁上がり
+		if (v & STOP) sim_cancel(second);
+		else sim_at(sim_now + period(), second);
+	}
+	if (r == TIMER || r == TCTRL) tcount = rtc8564_reg[TIMER];
+	int_update();
+}
+
+static void i2c_start(uint8_t read) {
+	access = 1;
+	if (!read) addr_next = 1;
+}
+
+static uint8_t i2c_write(uint8_t data) {
+	if (addr_next) {
+		ptr = data & 0x0F;
+		addr_next = 0;
+	} else {
+		reg_write(ptr, data);
+		ptr = (ptr + 1) & 0x0F;
+	}
+	return 1;
+}
+
+static uint8_t i2c_read(void) {
+	uint8_t v = rtc8564_reg[ptr];
+	ptr = (ptr + 1) & 0x0F;
+	return v;
+}
+
+// 転送終了：保留していた秒を進める
+static void i2c_stop(void) {
+	access = 0;
+	while (held) {
+		held--;
+		if (!(rtc8564_reg[CTRL1] & STOP)) count();
+	}
+}
+
+static const sim_i2c_dev_t dev = { 0xA2, i2c_start, i2c_write, i2c_read, i2c_stop };
+
+void rtc8564_init(uint8_t fresh, uint64_t phase) {
+	static const uint8_t init_fresh[16] = {
+		0x00, 0x00, 0x80, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x80, 0x80, 0x80, 0x80, 0x80, 0x03, 0x00
+	};
+	static const uint8_t init_set[16] = {
+		0x00, TITP | AIE | TIE, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x25, 0x80, 0x80, 0x80, 0x80, 0x83, 0x82, 0x01
+	};
+	static uint8_t attached;
+	for (uint8_t i = 0; i < 16; i++) rtc8564_reg[i] = fresh ? init_fresh[i] : init_set[i];
+	tcount = rtc8564_reg[TIMER];
+	if (!attached) sim_i2c_attach(&dev);
+	attached = 1;
+	sim_at(sim_now + (phase ? phase : period()), second);
+	int_update();
+}
+
+void rtc8564_set(uint8_t y, uint8_t mo, uint8_t d, uint8_t h, uint8_t mi, uint8_t s) {
+	rtc8564_reg[SEC] = (rtc8564_reg[SEC] & 0x80) | bcd(s);
+	rtc8564_reg[MIN] = bcd(mi);
+	rtc8564_reg[HOUR] = bcd(h);
+	rtc8564_reg[DAY] = bcd(d);
+	rtc8564_reg[MONTH] = (rtc8564_reg[MONTH] & 0x80) | bcd(mo);
+	rtc8564_reg[YEAR] = bcd(y);
+}
+
+void rtc8564_time(char *buf) {
+	const uint8_t *r = rtc8564_reg;
+	snprintf(buf, 13, "%02X%02X%02X%02X%02X%02X",
+		r[YEAR], r[MONTH] & 0x1F, r[DAY], r[HOUR], r[MIN], r[SEC] & 0x7F);
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef RTC8564_H
+#define RTC8564_H
+
+#include <stdint.h>
+
+// RTC-8564のモデル（I2Cスレーブ0xA2、レジスタ0x00?0x0F）
+// 計時、STOPによる分周器リセット、定周期タイマー（1Hz）の/INTパルス、アラーム（AF）の/INT保持、
+// 転送中の時刻更新の保留（STOP受信後にまとめて進める）を持つ
+
+extern uint8_t rtc8564_reg[16];       // レジスタ（読み出される値）
+extern uint32_t rtc8564_writes;       // マスタから書き込まれたレジスタ数
+
+// 電源投入：fresh=1で初回（VL=1、CLKOUT=0x80、タイマー停止）、0で設定済み（CLKOUT 1Hz、タイマー1秒）
+// phaseは最初の秒の桁上がりまでの時間（sim_time_t、0で1秒）
+extern void rtc8564_init(uint8_t fresh, uint64_t phase);
+extern void rtc8564_set(uint8_t y, uint8_t mo, uint8_t d, uint8_t h, uint8_t mi, uint8_t s); // 2進
+extern void rtc8564_time(char *buf);  // "YYMMDDhhmmss"（13バイト）
+
+#endif
\ No newline at end of file
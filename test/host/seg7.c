@@ -0,0 +1,78 @@
+#include <string.h>
+#include "seg7.h"
+
+// 回路：PORTBのビット→セグメント（a=PB6 b=PB7 c=PB3 d=PB4 e=PB2 f=PB1 g=PB0 dp=PB5、LOWで点灯）
+// COM：PD0=秒一の位 PD1=秒十の位 PC0=分一の位 PC1=分十の位 PD4=時一の位 PD5=時十の位 PD7=表示灯
+// 表示灯：c?fの4セグメント=コロン、a=AM、b=PM、g=LED7、dp=LED8
+
+extern uint8_t mux_img[7][4];
+
+#define SA 0x01
+#define SB 0x02
+#define SC 0x04
+#define SD 0x08
+#define SE 0x10
+#define SF 0x20
+#define SG 0x40
+
+static const struct {
+	uint8_t seg;
+	char c;
+} glyph[] = {
+	{SA|SB|SC|SD|SE|SF, '0'}, {SB|SC, '1'}, {SA|SB|SD|SE|SG, '2'}, {SA|SB|SC|SD|SG, '3'},
+	{SB|SC|SF|SG, '4'}, {SA|SC|SD|SF|SG, '5'}, {SA|SC|SD|SE|SF|SG, '6'}, {SC|SD|SE|SF|SG, '6'},
+	{SA|SB|SC, '7'}, {SA|SB|SC|SF, '7'}, {SA|SB|SC|SD|SE|SF|SG, '8'}, {SA|SB|SC|SD|SF|SG, '9'},
+	{SA|SB|SC|SF|SG, '9'}, {SG, '-'}, {0, ' '}
+};
+
+// PORTB→点灯セグメント（bit0:a?bit6:g、bit7:dp）
+static uint8_t lit(uint8_t pb) {
+	static const uint8_t pin[8] = {6, 7, 3, 4, 2, 1, 0, 5};
+	uint8_t s = 0;
+	for (uint8_t i = 0; i < 8; i++) {
+		if (!(pb & (1 << pin[i]))) s |= 1 << i;
+	}
+	return s;
+}
+
+// スロットのCOMピン→桁位置（なければ0xFF）
+static uint8_t position(const uint8_t *img) {
+	if (img[2] & (1 << 0)) return 0;
+	if (img[2] & (1 << 1)) return 1;
+	if (img[1] & (1 << 0)) return 2;
+	if (img[1] & (1 << 1)) return 3;
+	if (img[2] & (1 << 4)) return 4;
+	if (img[2] & (1 << 5)) return 5;
+	if (img[2] & (1 << 7)) return 6;
+	return 0xFF;
+}
+
+void seg7_read(seg7_t *d) {
+	uint8_t s[7] = {0};
+	memset(d, 0, sizeof(*d));
+	for (uint8_t i = 0; i < 7; i++) {
+		uint8_t p = position(mux_img[i]);
+		if (p == 0xFF) continue;
+		s[p] = lit(mux_img[i][0]);
+		d->on[p] = mux_img[i][3];
+	}
+
+	d->colon = (s[6] & (SC|SD|SE|SF)) == (SC|SD|SE|SF);
+	d->am = (s[6] & SA) != 0;
+	d->pm = (s[6] & SB) != 0;
+	d->led7 = (s[6] & SG) != 0;
+	d->led8 = (s[6] & 0x80) != 0;
+
+	// 時十・時一 [区切り] 分十・分一 [区切り] 秒十・秒一：ドットはその桁の後ろ、なければコロンか空白
+	char *t = d->text;
+	for (int8_t p = 5; p >= 0; p--) {
+		char c = '?';
+		for (uint8_t g = 0; g < sizeof(glyph) / sizeof(glyph[0]); g++) {
+			if (glyph[g].seg == (s[p] & 0x7F)) c = glyph[g].c;
+		}
+		*t++ = c;
+		if (s[p] & 0x80) *t++ = '.';
+		else if (p == 4 || p == 2) *t++ = d->colon ? ':' : ' ';
+	}
+	*t = 0;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef SEG7_H
+#define SEG7_H
+
+#include <stdint.h>
+
+// 7セグメント表示の読み取り：多重化スロットのポートイメージ（main.cのmux_img[]）を
+// 回路のとおりに解釈する（COMピンで桁、PORTBの各ビットでセグメント、LOWで点灯）
+typedef struct {
+	char text[16];      // "12:34:56"、"25.06.09."、"01:23.45"。消灯桁は空白、未知のパターンは'?'
+	uint8_t colon, am, pm, led7, led8;
+	uint8_t on[7];      // 桁（0:秒一の位?5:時十の位、6:表示灯）毎の点灯時間（Timer2カウント）
+} seg7_t;
+
+extern void seg7_read(seg7_t *d);
+
+#endif
\ No newline at end of file
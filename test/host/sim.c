@@ -0,0 +1,602 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/twi.h>
+#include "config.h"
+#include "sim.h"
+
+// シミュレーター本体：時間と割込み、Timer1/Timer2、ピン、TWI、EEPROM、USART0のモデル
+// タイマーとUSARTの設定はファームウェアが書いたレジスタから読む（config.hの値を直接使わない）
+
+#define SIM_DEF8(n)  volatile uint8_t n;
+#define SIM_DEF16(n) volatile uint16_t n;
+SIM_REGS(SIM_DEF8, SIM_DEF16)
+
+#define NEVER       UINT64_MAX
+#define B(v)        (1U << (v))
+#define POLL_CYCLES 8    // 状態待ちのポーリング1回（メインコンテキストで動作中のTWI・EEPROMを読むたびに進める）
+#define EE_WRITE_PS (3400ULL * SIM_US) // EEPROM 1バイトの書き込み時間（3.4ms）
+
+sim_time_t sim_now;
+sim_cfg_t sim_cfg;
+volatile uint8_t sim_sreg_i;
+uint32_t sim_isr_count[SIM_VEC_NUM];
+
+static uint16_t flags;          // 立っている割込みフラグ（エッジ・比較一致、B(SIM_xxx)）
+static uint8_t in_vec = 0xFF;   // 実行中のベクタ（0xFF：メインコンテキスト）
+static uint8_t busy_depth;      // ビジーウェイト中（sim_scriptの事象を呼ばない）
+
+// 割込みベクタ（ファームウェア側で定義されていなければNULL）
+#define SIM_VECTOR(n) extern void n(void) __attribute__((weak));
+SIM_VECTOR(INT0_vect) SIM_VECTOR(PCINT1_vect) SIM_VECTOR(TIMER2_COMPA_vect) SIM_VECTOR(TIMER2_COMPB_vect)
+SIM_VECTOR(TIMER1_COMPA_vect) SIM_VECTOR(USART_RX_vect) SIM_VECTOR(USART_UDRE_vect)
+SIM_VECTOR(EE_READY_vect) SIM_VECTOR(TWI_vect)
+
+static void (*vector(uint8_t v))(void) {
+	switch (v) {
+		case SIM_INT0:   return INT0_vect;
+		case SIM_PCINT1: return PCINT1_vect;
+		case SIM_T2A:    return TIMER2_COMPA_vect;
+		case SIM_T2B:    return TIMER2_COMPB_vect;
+		case SIM_T1A:    return TIMER1_COMPA_vect;
+		case SIM_RX:     return USART_RX_vect;
+		case SIM_UDRE:   return USART_UDRE_vect;
+		case SIM_EE:     return EE_READY_vect;
+		default:         return TWI_vect;
+	}
+}
+
+void sim_fatal(const char *msg) {
+	fprintf(stderr, "sim: %s (t=%.6f s)\n", msg, sim_now / (double)SIM_SEC);
+	exit(2);
+}
+
+// CPUのnサイクル（内部RCの誤差を含む）
+sim_time_t sim_cycles(uint32_t n) {
+	return (sim_time_t)(n * 1e12 / (F_CPU * (1.0 + sim_cfg.cpu_ppm * 1e-6)) + 0.5);
+}
+
+void sim_cli(void) {
+	sim_sreg_i = 0;
+}
+
+void sim_sei(void) {
+	sim_sreg_i = 1;
+}
+
+// ---- 事象 ----
+
+#define EV_NUM 8
+static struct {
+	void (*fn)(void);
+	sim_time_t at;
+	uint8_t script;
+} ev[EV_NUM];
+
+static void at(sim_time_t t, void (*fn)(void), uint8_t script) {
+	int free = -1;
+	for (int i = 0; i < EV_NUM; i++) {
+		if (ev[i].fn == fn) free = i;
+		else if (!ev[i].fn && free < 0) free = i;
+	}
+	if (free < 0) sim_fatal("too many scheduled events");
+	ev[free].fn = fn;
+	ev[free].at = t;
+	ev[free].script = script;
+}
+
+void sim_at(sim_time_t t, void (*fn)(void)) {
+	at(t, fn, 0);
+}
+
+void sim_script(sim_time_t t, void (*fn)(void)) {
+	at(t, fn, 1);
+}
+
+void sim_cancel(void (*fn)(void)) {
+	for (int i = 0; i < EV_NUM; i++) {
+		if (ev[i].fn == fn) ev[i].fn = 0;
+	}
+}
+
+// ---- タイマー（CTCモード） ----
+
+static sim_time_t t1_next, t2_next, t2_start, t2b_next;
+
+static uint16_t t1_div(void) {
+	static const uint16_t div[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+	return div[TCCR1B & 7];
+}
+
+static uint16_t t2_div(void) {
+	static const uint16_t div[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+	return div[TCCR2B & 7];
+}
+
+static void timers_sync(void) {
+	if (!t1_div()) t1_next = 0;
+	else if (!t1_next) t1_next = sim_now + sim_cycles((OCR1A + 1UL) * t1_div());
+	if (!t2_div()) t2_next = t2b_next = 0;
+	else if (!t2_next) {
+		t2_start = sim_now;
+		t2_next = sim_now + sim_cycles((OCR2A + 1UL) * t2_div());
+	}
+}
+
+// スロット内の比較B：OCR2BがOCR2A以下なら一致する
+static void t2b_schedule(void) {
+	t2b_next = (t2_next && OCR2B <= OCR2A) ? t2_start + sim_cycles((uint32_t)OCR2B * t2_div()) : 0;
+}
+
+// 割込み時点のカウンタ値
+static void counters_sync(void) {
+	if (t1_next) {
+		sim_time_t rem = (t1_next - sim_now) / sim_cycles(t1_div()); // 次の一致までのカウント（1?OCR1A+1）
+		io_TCNT1 = (uint16_t)(rem > OCR1A ? 0 : OCR1A + 1 - rem);
+	}
+	if (t2_next) TCNT2 = (uint8_t)((sim_now - t2_start) / sim_cycles(t2_div()));
+}
+
+// ---- ピン ----
+
+static uint8_t sw_pressed;      // スイッチ（bit0:S1, bit1:S2）
+static uint8_t int_level = 1;   // RTCの/INT
+static uint8_t scl_low;         // 前回見たSCLの駆動（バス復旧のクロック数え）
+uint8_t sim_sda_stuck;
+
+static void pins_sync(void) {
+	uint8_t d = io_DDRC;
+	uint8_t low = (d >> PC5) & 1;
+	if (scl_low && !low && sim_sda_stuck) sim_sda_stuck--; // SCLの立ち上がりでスレーブが1ビット進む
+	scl_low = low;
+
+	uint8_t p = (uint8_t)((~sw_pressed & 3) << PC2);
+	if (!sim_sda_stuck && !(d & (1 << PC4))) p |= 1 << PC4;
+	if (!low) p |= 1 << PC5;
+	PINC = p;
+	PIND = int_level ? (1 << PD2) : 0;
+}
+
+void sim_switch(uint8_t pressed) {
+	uint8_t chg = (sw_pressed ^ pressed) & 3;
+	sw_pressed = pressed & 3;
+	if (chg && (PCMSK1 & (chg << PCINT10))) flags |= B(SIM_PCINT1);
+	pins_sync();
+}
+
+// INT0は立ち下がりエッジ（EICRA ISC01）
+void sim_int_line(uint8_t level) {
+	level = level ? 1 : 0;
+	if (int_level && !level) flags |= B(SIM_INT0);
+	int_level = level;
+	pins_sync();
+}
+
+// ---- TWI（マスタ送受信） ----
+// TWCRのbit1（予約、ソフトウェアは0を書く）を目印にし、0なら書き込まれたとして操作を実行する
+
+#define TWCR_MARK 0x02
+enum { TWI_IDLE, TWI_STARTED, TWI_MT, TWI_MR, TWI_NOSLAVE };
+
+static struct {
+	uint8_t flag;           // TWINT
+	uint8_t state;
+	uint8_t status;         // TWSRの上位5bit
+	uint8_t data;           // 受信完了時のTWDR
+	sim_time_t done;        // 実行中の操作の完了時刻（0：なし）
+	uint8_t active;         // 操作中（完了しない障害を含む）
+	const sim_i2c_dev_t *dev;
+	const sim_i2c_dev_t *attached[4];
+	uint8_t fault;
+	int16_t fault_n;
+} twi = { .status = TW_NO_INFO };
+uint32_t sim_twi_ops;
+
+void sim_i2c_attach(const sim_i2c_dev_t *dev) {
+	for (int i = 0; i < 4; i++) {
+		if (!twi.attached[i]) {
+			twi.attached[i] = dev;
+			return;
+		}
+	}
+	sim_fatal("too many I2C devices");
+}
+
+void sim_twi_fault(uint8_t kind, int16_t count) {
+	twi.fault = kind;
+	twi.fault_n = count;
+}
+
+static uint8_t fault_take(void) {
+	if (!twi.fault || !twi.fault_n) return SIM_TWI_OK;
+	if (twi.fault_n > 0 && --twi.fault_n == 0) {
+		uint8_t f = twi.fault;
+		twi.fault = SIM_TWI_OK;
+		return f;
+	}
+	return twi.fault;
+}
+
+static sim_time_t twi_bit(void) {
+	static const uint8_t ps[4] = {1, 4, 16, 64};
+	return sim_cycles(16 + 2UL * TWBR * ps[io_TWSR & 3]);
+}
+
+static void twi_release(void) {
+	if (twi.dev && twi.dev->stop) twi.dev->stop();
+	twi.dev = 0;
+	twi.state = TWI_IDLE;
+}
+
+static void twi_op(uint8_t cr) {
+	uint8_t f, n = 9;
+
+	twi.done = 0; // 前の操作（完了しなかった場合を含む）を打ち切る
+	twi.active = 0;
+	if (cr & (1 << TWSTO)) {
+		twi_release();
+		if (!(cr & (1 << TWSTA))) return; // STOPは完了通知なし
+	}
+	if (!(cr & (1 << TWSTA)) && (twi.state == TWI_IDLE || twi.state == TWI_NOSLAVE)) return; // バス未取得
+
+	sim_twi_ops++;
+	f = fault_take();
+	if (cr & (1 << TWSTA)) {
+		twi.status = (twi.state == TWI_IDLE) ? TW_START : TW_REP_START;
+		if (twi.dev && twi.dev->stop) twi.dev->stop();
+		twi.dev = 0;
+		twi.state = TWI_STARTED;
+		n = 1;
+		if (sim_sda_stuck) f = SIM_TWI_HANG; // SDAがLOWのままではSTARTを出せない
+	} else if (twi.state == TWI_STARTED) {
+		uint8_t sla = io_TWDR, rd = sla & TW_READ;
+		const sim_i2c_dev_t *d = 0;
+		for (int i = 0; i < 4; i++) {
+			if (twi.attached[i] && twi.attached[i]->adr == (sla & ~TW_READ)) d = twi.attached[i];
+		}
+		if (d && f != SIM_TWI_NACK) {
+			twi.dev = d;
+			twi.state = rd ? TWI_MR : TWI_MT;
+			twi.status = rd ? TW_MR_SLA_ACK : TW_MT_SLA_ACK;
+			if (d->start) d->start(rd);
+		} else {
+			twi.state = TWI_NOSLAVE;
+			twi.status = rd ? TW_MR_SLA_NACK : TW_MT_SLA_NACK;
+		}
+	} else if (twi.state == TWI_MT) {
+		uint8_t ack = (f != SIM_TWI_NACK) && twi.dev->write(io_TWDR);
+		twi.status = ack ? TW_MT_DATA_ACK : TW_MT_DATA_NACK;
+	} else {
+		twi.data = twi.dev->read();
+		twi.status = (cr & (1 << TWEA)) ? TW_MR_DATA_ACK : TW_MR_DATA_NACK;
+	}
+
+	if (f == SIM_TWI_BUSERR) {
+		twi_release();
+		twi.status = TW_BUS_ERROR;
+	}
+	twi.done = (f == SIM_TWI_HANG) ? 0 : sim_now + n * twi_bit();
+	twi.active = 1;
+}
+
+static void twi_sync(void) {
+	uint8_t cr = io_TWCR;
+	if (!(cr & TWCR_MARK)) {
+		if (!(cr & (1 << TWEN))) { // TWI停止：転送を打ち切りピンを開放
+			twi_release();
+			twi.flag = 0;
+			twi.done = 0;
+			twi.active = 0;
+			twi.status = TW_NO_INFO;
+		} else if (cr & (1 << TWINT)) { // TWINTに1を書いて次の操作
+			twi.flag = 0;
+			twi.status = TW_NO_INFO;
+			twi_op(cr);
+		}
+	}
+	io_TWCR = (uint8_t)((cr & ~((1 << TWINT) | (1 << TWSTO))) | (twi.flag ? (1 << TWINT) : 0) | TWCR_MARK);
+	io_TWSR = (uint8_t)(twi.status | (io_TWSR & 3));
+}
+
+static void twi_complete(void) {
+	twi_sync();
+	twi.done = 0;
+	twi.active = 0;
+	if (twi.state == TWI_MR && (twi.status == TW_MR_DATA_ACK || twi.status == TW_MR_DATA_NACK)) io_TWDR = twi.data;
+	twi.flag = 1;
+	io_TWCR |= 1 << TWINT;
+	io_TWSR = (uint8_t)(twi.status | (io_TWSR & 3));
+}
+
+// ---- 表示のCOM（点灯時間の積算） ----
+
+static sim_time_t com_on[7];
+static uint8_t com_lit = 0xFF;  // 点灯中のCOM（桁位置、0xFFでなし）
+static sim_time_t com_since;
+
+// COMピン（seg7.cと同じ桁位置：PD0 PD1 PC0 PC1 PD4 PD5 PD7）
+static uint8_t com_pos(void) {
+	static const uint8_t bit[7] = {0, 1, 0, 1, 4, 5, 7};
+	for (uint8_t p = 0; p < 7; p++) {
+		uint8_t port = (p == 2 || p == 3) ? PORTC : PORTD;
+		if (port & (1 << bit[p])) return p;
+	}
+	return 0xFF;
+}
+
+// 割込みから戻るたびに呼ぶ（多重化のポート出力はTimer2の割込みのみ）
+static void com_sync(void) {
+	uint8_t p = com_pos();
+	if (p == com_lit) return;
+	if (com_lit != 0xFF) com_on[com_lit] += sim_now - com_since;
+	com_lit = p;
+	com_since = sim_now;
+}
+
+sim_time_t sim_com_time(uint8_t pos) {
+	return com_on[pos] + (pos == com_lit ? sim_now - com_since : 0);
+}
+
+// ---- EEPROM ----
+
+uint8_t sim_eeprom[512];
+uint32_t sim_ee_writes;
+uint8_t sim_ee_lost;
+static struct {
+	uint8_t busy;
+	sim_time_t done;
+	uint32_t cut;      // 電源断する書き込み（sim_ee_writesの値、0でなし）
+	uint8_t partial;   // 電源断したセルの値
+} ee;
+
+void sim_ee_power_cut(uint32_t n, uint8_t partial) {
+	ee.cut = n ? sim_ee_writes + n : 0;
+	ee.partial = partial;
+	sim_ee_lost = 0;
+}
+
+static void ee_sync(void) {
+	uint8_t c = io_EECR;
+	if (c & (1 << EERE)) { // 読み出しは即時（書き込み中は無視）
+		if (!ee.busy) io_EEDR = sim_eeprom[EEAR & E2END];
+		c &= ~(1 << EERE);
+	}
+	if ((c & (1 << EEPE)) && !ee.busy) {
+		if (c & (1 << EEMPE)) {
+			sim_ee_writes++;
+			if (sim_ee_writes == ee.cut) {
+				sim_eeprom[EEAR & E2END] = ee.partial; // 消去・書き込みの途中
+				sim_ee_lost = 1;
+			} else if (!sim_ee_lost) {
+				sim_eeprom[EEAR & E2END] = io_EEDR;
+			}
+			ee.busy = 1;
+			ee.done = sim_now + EE_WRITE_PS;
+		} else {
+			c &= ~(1 << EEPE); // EEMPEなしの書き込み要求は無効
+		}
+		c &= ~(1 << EEMPE);
+	}
+	io_EECR = c;
+}
+
+// ---- USART0 ----
+
+char sim_uart_tx[4096];
+uint16_t sim_uart_txlen;
+static struct {
+	uint8_t q[1024];
+	uint16_t head, tail;
+	sim_time_t rx_next;     // 次の受信完了（0：なし）
+	sim_time_t tx_done;     // 送信中の完了（0：なし）
+	uint8_t written;        // UDRE割込み内でUDR0に書いた
+} uart;
+
+static sim_time_t uart_frame(void) {
+	uint32_t div = (UCSR0A & (1 << U2X0)) ? 8 : 16;
+	return 10 * sim_cycles(div * (UBRR0 + 1UL)); // 8N1
+}
+
+void sim_uart_rx(const char *s, uint16_t len) {
+	while (len--) {
+		uint16_t next = (uart.head + 1) % sizeof(uart.q);
+		if (next == uart.tail) sim_fatal("UART input overflow");
+		uart.q[uart.head] = (uint8_t)*s++;
+		uart.head = next;
+	}
+	if (!uart.rx_next) uart.rx_next = sim_now + uart_frame();
+}
+
+static void uart_rx_done(void) {
+	if (UCSR0B & (1 << RXEN0)) {
+		if (UCSR0A & (1 << RXC0)) {
+			UCSR0A |= 1 << DOR0; // 前の文字が読まれていない：新しい文字は失われる
+		} else {
+			io_UDR0 = uart.q[uart.tail];
+			UCSR0A |= 1 << RXC0;
+		}
+	}
+	uart.tail = (uart.tail + 1) % sizeof(uart.q);
+	uart.rx_next = (uart.tail != uart.head) ? sim_now + uart_frame() : 0;
+}
+
+static void uart_tx(void) {
+	if (sim_uart_txlen < sizeof(sim_uart_tx)) sim_uart_tx[sim_uart_txlen++] = (char)io_UDR0;
+	uart.tx_done = sim_now + uart_frame();
+}
+
+// ---- ブザー ----
+
+sim_tone_t sim_tone[SIM_TONE_LOG];
+uint16_t sim_tones;
+
+void sim_buzzer(uint8_t ocr, uint8_t cs) {
+	sim_tone_t *t = &sim_tone[sim_tones++ % SIM_TONE_LOG];
+	t->t = sim_now;
+	t->ocr = ocr;
+	t->cs = cs;
+}
+
+// ---- レジスタアクセス ----
+
+static void periph_sync(void) {
+	twi_sync();
+	ee_sync();
+	pins_sync();
+	timers_sync();
+}
+
+volatile uint8_t *sim_io(volatile uint8_t *reg) {
+	periph_sync();
+	if (reg == &io_TIFR1) io_TIFR1 = (flags & B(SIM_T1A)) ? (1 << OCF1A) : 0;
+	if (reg == &io_TIFR2) io_TIFR2 = ((flags & B(SIM_T2A)) ? (1 << OCF2A) : 0) | ((flags & B(SIM_T2B)) ? (1 << OCF2B) : 0);
+	if (reg == &io_UDR0) {
+		if (in_vec == SIM_UDRE) uart.written = 1;
+		if (in_vec == SIM_RX) UCSR0A &= ~((1 << RXC0) | (1 << FE0) | (1 << DOR0)); // 読み出しで受信完了を解除
+	}
+	if (in_vec == 0xFF && ((reg == &io_TWCR && twi.active) || (reg == &io_EECR && ee.busy))) {
+		sim_busy(sim_cycles(POLL_CYCLES));
+	}
+	return reg;
+}
+
+// TCNT1：計測（prof.c）の読み出しでカウンタを現在時刻に合わせる
+volatile uint16_t *sim_io16(volatile uint16_t *reg) {
+	periph_sync();
+	counters_sync();
+	return reg;
+}
+
+void sim_delay_us(double us) {
+	sim_busy(sim_cycles((uint32_t)(us * (F_CPU / 1e6) + 0.5)));
+}
+
+// ---- 時間の進行と割込み ----
+
+static __attribute__((constructor)) void sim_power_on(void) {
+	memset(sim_eeprom, 0xFF, sizeof(sim_eeprom));
+	io_TWSR = TW_NO_INFO;
+	pins_sync();
+}
+
+static sim_time_t next_event(void) {
+	sim_time_t t = NEVER;
+	periph_sync(); // 書き込まれたばかりの操作を開始
+#define MIN(x) if ((x) && (x) < t) t = (x)
+	MIN(t1_next);
+	MIN(t2_next);
+	MIN(t2b_next);
+	MIN(twi.done);
+	if (ee.busy) MIN(ee.done);
+	MIN(uart.rx_next);
+	MIN(uart.tx_done);
+#undef MIN
+	for (int i = 0; i < EV_NUM; i++) {
+		if (ev[i].fn && (!ev[i].script || !busy_depth) && ev[i].at < t) t = ev[i].at;
+	}
+	return t;
+}
+
+// 時刻tまで進め、期限の来た事象を処理（割込みはフラグを立てるだけ）
+static void advance(sim_time_t t) {
+	if (t > sim_now) sim_now = t;
+	periph_sync();
+	if (t1_next && t1_next <= sim_now) {
+		flags |= B(SIM_T1A);
+		t1_next += sim_cycles((OCR1A + 1UL) * t1_div());
+	}
+	if (t2_next && t2_next <= sim_now) {
+		flags |= B(SIM_T2A);
+		t2_start = t2_next;
+		t2_next += sim_cycles((OCR2A + 1UL) * t2_div());
+		t2b_schedule();
+	}
+	if (t2b_next && t2b_next <= sim_now) {
+		flags |= B(SIM_T2B);
+		t2b_next = 0;
+	}
+	if (twi.done && twi.done <= sim_now) twi_complete();
+	if (ee.busy && ee.done <= sim_now) {
+		ee.busy = 0;
+		io_EECR &= ~(1 << EEPE);
+	}
+	if (uart.rx_next && uart.rx_next <= sim_now) uart_rx_done();
+	if (uart.tx_done && uart.tx_done <= sim_now) uart.tx_done = 0;
+	for (int i = 0; i < EV_NUM; i++) {
+		if (ev[i].fn && ev[i].at <= sim_now && (!ev[i].script || !busy_depth)) {
+			void (*fn)(void) = ev[i].fn;
+			ev[i].fn = 0;
+			fn();
+		}
+	}
+}
+
+static uint16_t pending(void) {
+	uint16_t p = 0;
+	periph_sync();
+	if ((flags & B(SIM_INT0)) && (EIMSK & (1 << INT0))) p |= B(SIM_INT0);
+	if ((flags & B(SIM_PCINT1)) && (PCICR & (1 << PCIE1))) p |= B(SIM_PCINT1);
+	if ((flags & B(SIM_T2A)) && (TIMSK2 & (1 << OCIE2A))) p |= B(SIM_T2A);
+	if ((flags & B(SIM_T2B)) && (TIMSK2 & (1 << OCIE2B))) p |= B(SIM_T2B);
+	if ((flags & B(SIM_T1A)) && (TIMSK1 & (1 << OCIE1A))) p |= B(SIM_T1A);
+	if ((UCSR0A & (1 << RXC0)) && (UCSR0B & (1 << RXCIE0))) p |= B(SIM_RX);
+	if ((UCSR0B & (1 << UDRIE0)) && (UCSR0B & (1 << TXEN0)) && !uart.tx_done) p |= B(SIM_UDRE);
+	if ((io_EECR & (1 << EERIE)) && !ee.busy) p |= B(SIM_EE);
+	if (twi.flag && (io_TWCR & (1 << TWIE)) && (io_TWCR & (1 << TWEN))) p |= B(SIM_TWI);
+	return p;
+}
+
+// 割込み処理（Iフラグが1の間、優先順に）：処理した数を返す
+static uint32_t deliver(void) {
+	uint32_t n = 0;
+	uint16_t p;
+	while (sim_sreg_i && (p = pending())) {
+		uint8_t v = (uint8_t)__builtin_ctz(p);
+		void (*fn)(void) = vector(v);
+		if (!fn) sim_fatal("interrupt enabled without a vector");
+		flags &= ~B(v);
+		counters_sync();
+		sim_isr_count[v]++;
+		uart.written = 0;
+		sim_sreg_i = 0;
+		in_vec = v;
+		fn();
+		in_vec = 0xFF;
+		sim_sreg_i = 1;
+		if (v == SIM_UDRE && uart.written) uart_tx();
+		if (v == SIM_T2A) t2b_schedule(); // 新しい点灯時間で比較Bを決め直す
+		com_sync();
+		if (++n > 100000) sim_fatal("interrupt storm");
+	}
+	return n;
+}
+
+void sim_idle(void) {
+	sim_sreg_i = 1;
+	while (!deliver()) {
+		sim_time_t t = next_event();
+		if (t == NEVER) sim_fatal("sleep with no wake-up source");
+		advance(t);
+	}
+}
+
+void sim_run(sim_time_t d) {
+	sim_time_t end = sim_now + d;
+	for (;;) {
+		deliver();
+		sim_time_t t = next_event();
+		if (t > end) break;
+		advance(t);
+	}
+	sim_now = end;
+}
+
+void sim_busy(sim_time_t d) {
+	sim_time_t end = sim_now + d, t;
+	busy_depth++;
+	while ((t = next_event()) <= end) advance(t);
+	busy_depth--;
+	sim_now = end;
+}
\ No newline at end of file
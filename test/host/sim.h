@@ -0,0 +1,99 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+// ホスト上のATmega88Pシミュレーター（ファームウェアのソースと割込みをそのまま動かす）
+// 時間はhal_idle（次の割込みまで）、sim_run、ビジーウェイト（_delay_us、TWI・EEPROMの状態待ち）でのみ進み、
+// それ以外のコードの実行時間は0とみなす。割込みは時間が進んだときにIフラグが1なら優先順に呼ぶ
+
+// シミュレーション時間（ピコ秒）
+typedef uint64_t sim_time_t;
+#define SIM_US   1000000ULL
+#define SIM_MS   1000000000ULL
+#define SIM_SEC  1000000000000ULL
+
+extern sim_time_t sim_now;
+
+// 割込みベクタ番号（値が小さいほど優先）
+enum {
+	SIM_INT0, SIM_PCINT1, SIM_T2A, SIM_T2B, SIM_T1A,
+	SIM_RX, SIM_UDRE, SIM_EE, SIM_TWI, SIM_VEC_NUM
+};
+
+// 動作条件（sim_runの前に設定）
+typedef struct {
+	double cpu_ppm;   // CPUクロック（内部RC）の誤差、正で速い
+	double rtc_ppm;   // RTC水晶の誤差、正で速い
+} sim_cfg_t;
+extern sim_cfg_t sim_cfg;
+
+extern uint32_t sim_isr_count[SIM_VEC_NUM]; // ベクタ毎の呼び出し回数
+
+// 実行
+extern void sim_idle(void);                // 次の割込みまで進めて処理（hal_idle）
+extern void sim_run(sim_time_t t);         // t時間進める（Iフラグが1なら割込みを処理）
+extern void sim_busy(sim_time_t t);        // ビジーウェイト（割込みなし、周辺は進む）
+extern sim_time_t sim_cycles(uint32_t n);  // CPUのnサイクルの時間
+
+// 時刻atに関数を呼ぶ（同じ関数の再登録は時刻の更新）
+//   sim_at：周辺モデルの事象（ビジーウェイト中も呼ぶ）
+//   sim_script：テストの操作・確認（メインコンテキストの区切り＝sim_idle/sim_run中のみ、
+//               中でsim_idle/sim_runを呼ばないこと）
+extern void sim_at(sim_time_t at, void (*fn)(void));
+extern void sim_script(sim_time_t at, void (*fn)(void));
+extern void sim_cancel(void (*fn)(void));
+
+// ピン：スイッチ（bit0:S1, bit1:S2、押下で1）とRTCの/INT（0でLOW）
+extern void sim_switch(uint8_t pressed);
+extern void sim_int_line(uint8_t level);
+
+// 表示：桁位置（0:秒一の位?5:時十の位、6:表示灯）毎のCOMの点灯時間の累計
+// UART_CONSOLE=1ではPD0（RXDのプルアップ）が常にHIGHのため桁0は数えられない
+extern sim_time_t sim_com_time(uint8_t pos);
+
+// I2Cスレーブ（sim_i2c_attachで登録、アドレスは書き込み側）
+typedef struct {
+	uint8_t adr;
+	void (*start)(uint8_t read);     // SLA受信（ACK済み）
+	uint8_t (*write)(uint8_t data);  // マスタ送信（戻り値1でACK）
+	uint8_t (*read)(void);           // マスタ受信
+	void (*stop)(void);              // STOPまたはリピートスタート
+} sim_i2c_dev_t;
+extern void sim_i2c_attach(const sim_i2c_dev_t *dev);
+
+// TWIの障害注入：次のcount回の操作（START、SLA、データ）に適用、count<0で解除まで継続
+#define SIM_TWI_OK      0
+#define SIM_TWI_HANG    1 // 完了しない（TWINTが立たない）
+#define SIM_TWI_NACK    2 // SLA・データにNACK
+#define SIM_TWI_BUSERR  3 // バスエラー（ステータス0x00）
+extern void sim_twi_fault(uint8_t kind, int16_t count);
+extern uint8_t sim_sda_stuck;              // スレーブがSDAをLOWに保持（SCLクロックで1ずつ減る）
+extern uint32_t sim_twi_ops;               // 開始したTWI操作の数
+
+// EEPROM
+extern uint8_t sim_eeprom[512];
+extern uint32_t sim_ee_writes;             // 開始した書き込みバイト数
+// 電源断：n回目（1で次）の書き込み中に電源が落ち、そのセルはpartial（消去・書き込みの途中）、以後の書き込みは
+// セルに届かない（ファームウェアはそのまま動くので、確認は再起動を模して行う）。n=0で解除
+extern void sim_ee_power_cut(uint32_t n, uint8_t partial);
+extern uint8_t sim_ee_lost;                // 電源断が起きた
+
+// USART0：受信データの投入と送信データ
+extern void sim_uart_rx(const char *s, uint16_t len);
+extern char sim_uart_tx[4096];
+extern uint16_t sim_uart_txlen;
+
+// ブザー（hal_buzzer_tone/hal_buzzer_offの記録）
+typedef struct {
+	sim_time_t t;
+	uint8_t ocr, cs;   // cs=0で停止
+} sim_tone_t;
+#define SIM_TONE_LOG 256
+extern sim_tone_t sim_tone[SIM_TONE_LOG];
+extern uint16_t sim_tones;                 // 記録数（SIM_TONE_LOGを超えたら古い記録を上書き）
+extern void sim_buzzer(uint8_t ocr, uint8_t cs);
+
+extern void sim_fatal(const char *msg);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#include <avr/interrupt.h>
+
+// ホスト用 <util/atomic.h>：avr-libcと同じくブロックを抜ける経路によらずIフラグを戻す
+static inline uint8_t sim_atomic_enter(void) {
+	uint8_t i = sim_sreg_i;
+	sim_cli();
+	return i;
+}
+
+static inline void sim_atomic_exit(const uint8_t *i) {
+	if (*i) sim_sei();
+}
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) \
+	for (uint8_t sim_i_ __attribute__((__cleanup__(sim_atomic_exit))) = sim_atomic_enter(), sim_once_ = 1; \
+	     sim_once_; sim_once_ = 0)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,13 @@
+#ifndef HOST_UTIL_CRC16_H
+#define HOST_UTIL_CRC16_H
+
+#include <stdint.h>
+
+// ホスト用 <util/crc16.h>：avr-libcの_crc8_ccitt_update（多項式0x07）と同じ結果
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data) {
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	return crc;
+}
+
+#endif
\ No newline at end of file
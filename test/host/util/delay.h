@@ -0,0 +1,10 @@
+#ifndef HOST_UTIL_DELAY_H
+#define HOST_UTIL_DELAY_H
+
+// ホスト用 <util/delay.h>：シミュレーション時間を進める（割込みは入らない）
+extern void sim_delay_us(double us);
+
+#define _delay_us(us) sim_delay_us(us)
+#define _delay_ms(ms) sim_delay_us((ms) * 1000.0)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+#include "rtc8564.h"
+#include "seg7.h"
+
+// シナリオ実行：ファームウェア（main.cをfirmware_mainとしてリンク）をシミュレーターで動かし、
+// 表示・RTC・ブザー・コンソール出力を確認する
+//   sim [-v] [-t 端末] シナリオ.sim
+//   -t：USART0を端末（ptyのスレーブ等）につなぎ、実時間と同じ速さで動かす（UART_CONSOLE=1のビルドで使う）
+// シナリオは1行1コマンド（#以降はコメント）、時間は 500ms・2s・3m・1h・2d（単位なしはms）
+//   rtc YYMMDDhhmmss      RTCの時刻（boot前は電池で保持していた時刻、boot後は外部からの書き換え）
+//   rtc_fresh             RTCを初回電源投入の状態に（VL=1、未設定）
+//   rtc_phase T           起動から最初の秒の桁上がりまで（既定500ms、boot前）
+//   cpu_ppm N / rtc_ppm N クロック誤差（boot前）
+//   boot                  ファームウェア起動（以降のコマンドはシミュレーション時間に沿って実行）
+//   run T                 T進める
+//   press S1|S2|S1+S2 T   押してT保持し離す（離した後50ms進める）
+//   expect "TEXT"         表示（'_'は任意の1文字）
+//   expect_led NAME 0|1   colon, am, pm, led7, led8
+//   expect_rtc YYMMDDhhmmss
+//   expect_clock          表示の時分秒がRTCと一致すること（24時間表記）
+//   expect_tones N        前回の確認以降の発音開始の回数
+//   uart "TEXT"           コンソールへ1行送る（CRを付加）
+//   expect_uart "TEXT"    コンソール出力にTEXTを含む行があること（その行までを読み捨てる）
+//   print                 表示を出力
+// PROF_STATS=1のビルド（build/sim_prof、make bench）はシナリオの終わりに計測の統計を出力し、
+// 予算超過（over）・割込みの取りこぼしがあれば失敗とする。シミュレーターでは命令の実行時間は0のため、
+// 計測値はモデル化した時間（TWIの転送、ビジーウェイト、EEPROM、割込みの待ち）のみ
+
+extern int firmware_main(void);
+
+#if PROF_STATS
+#include "prof.h"
+#endif
+
+static char **line;            // シナリオの行
+static int nline, pc;          // 行数、次に実行する行
+static const char *path;
+static int verbose, fails, checks;
+static uint16_t tones_seen;    // expect_tonesで確認済みの発音記録
+static uint16_t uart_seen;     // expect_uartで読み捨てた出力
+static uint8_t pressing;       // press実行中のスイッチ（離す待ち）
+static int tty = -1;           // -tの端末
+static struct timespec wall0;  // boot時の実時間
+
+static void step(void);
+
+static void fail(const char *fmt, const char *a, const char *b) {
+	fprintf(stderr, "%s:%d: ", path, pc);
+	fprintf(stderr, fmt, a, b);
+	fprintf(stderr, " (t=%.3f s)\n", sim_now / (double)SIM_SEC);
+	fails++;
+}
+
+#if PROF_STATS
+// 計測の統計（サイクル数）：予算超過・取りこぼしは失敗
+static void prof_report(void) {
+	static const char *const name[PROF_NUM] = {"T1", "T2", "INT0", "I2C"};
+	for (uint8_t i = 0; i < PROF_NUM; i++) {
+		const prof_slot_t *s = &prof.slot[i];
+		printf("%s: prof %-4s n %5u min %6lu max %6lu avg %6lu cycles, over %u\n", path, name[i], s->n,
+			(unsigned long)PROF_CYCLES(s->min), (unsigned long)PROF_CYCLES(s->max), (unsigned long)PROF_CYCLES(s->avg), s->over);
+		checks++;
+		if (s->over) fail("%s over budget%s", name[i], "");
+	}
+	printf("%s: prof missed T1 %u T2 %u, T1 latency %lu cycles, boot %lu cycles\n", path, prof.t1_missed, prof.t2_missed,
+		(unsigned long)PROF_CYCLES(prof.t1_latency), (unsigned long)PROF_CYCLES(prof.boot));
+	checks++;
+	if (prof.t1_missed || prof.t2_missed) fail("missed interrupts%s%s", "", "");
+}
+#endif
+
+static sim_time_t duration(const char *s) {
+	char *end;
+	double v = strtod(s, &end);
+	if (end == s) return 0;
+	if (!strncmp(end, "ms", 2) || !*end) return (sim_time_t)(v * SIM_MS);
+	if (!strncmp(end, "us", 2)) return (sim_time_t)(v * SIM_US);
+	if (*end == 's') return (sim_time_t)(v * SIM_SEC);
+	if (*end == 'm') return (sim_time_t)(v * 60 * SIM_SEC);
+	if (*end == 'h') return (sim_time_t)(v * 3600 * SIM_SEC);
+	if (*end == 'd') return (sim_time_t)(v * 86400 * SIM_SEC);
+	return 0;
+}
+
+// "..."の中身（引用符がなければ残り全部）
+static const char *quoted(char *s) {
+	char *q = strchr(s, '"');
+	if (!q) return s;
+	char *e = strrchr(q + 1, '"');
+	if (e) *e = 0;
+	return q + 1;
+}
+
+static int match(const char *pat, const char *s) {
+	if (strlen(pat) != strlen(s)) return 0;
+	for (; *pat; pat++, s++) {
+		if (*pat != '_' && *pat != *s) return 0;
+	}
+	return 1;
+}
+
+static uint8_t bcd2(const char *s) {
+	return (uint8_t)((s[0] - '0') * 10 + (s[1] - '0'));
+}
+
+static void rtc_cmd(const char *a) {
+	if (strlen(a) != 12) {
+		fail("bad time \"%s\"%s", a, "");
+		return;
+	}
+	rtc8564_set(bcd2(a), bcd2(a + 2), bcd2(a + 4), bcd2(a + 6), bcd2(a + 8), bcd2(a + 10));
+}
+
+static uint8_t switches(const char *a) {
+	if (!strcmp(a, "S1")) return 1;
+	if (!strcmp(a, "S2")) return 2;
+	if (!strcmp(a, "S1+S2")) return 3;
+	return 0;
+}
+
+static void print_display(void) {
+	seg7_t d;
+	seg7_read(&d);
+	printf("%10.3f  [%s]%s%s%s%s%s\n", sim_now / (double)SIM_SEC, d.text, d.colon ? " colon" : "",
+		d.am ? " AM" : "", d.pm ? " PM" : "", d.led7 ? " LED7" : "", d.led8 ? " LED8" : "");
+}
+
+// 確認系コマンド（0：該当なし）
+static int check(const char *cmd, char *arg) {
+	seg7_t d;
+	char buf[64];
+
+	if (!strcmp(cmd, "expect")) {
+		const char *want = quoted(arg);
+		seg7_read(&d);
+		if (!match(want, d.text)) fail("display \"%s\", expected \"%s\"", d.text, want);
+	} else if (!strcmp(cmd, "expect_led")) {
+		char name[16];
+		int v = -1;
+		sscanf(arg, "%15s %d", name, &v);
+		seg7_read(&d);
+		int got = !strcmp(name, "colon") ? d.colon : !strcmp(name, "am") ? d.am : !strcmp(name, "pm") ? d.pm :
+			!strcmp(name, "led7") ? d.led7 : !strcmp(name, "led8") ? d.led8 : -1;
+		if (got != v) fail("%s is %s", name, got ? "on" : "off");
+	} else if (!strcmp(cmd, "expect_rtc")) {
+		rtc8564_time(buf);
+		if (strcmp(buf, arg)) fail("RTC %s, expected %s", buf, arg);
+	} else if (!strcmp(cmd, "expect_clock")) {
+		char want[16];
+		rtc8564_time(buf);
+		snprintf(want, sizeof(want), "%.2s_%.2s_%.2s", buf + 6, buf + 8, buf + 10);
+		if (want[0] == '0') want[0] = ' '; // 時の十の位はゼロサプレス
+		seg7_read(&d);
+		if (!match(want, d.text)) fail("display \"%s\", RTC %s", d.text, want);
+	} else if (!strcmp(cmd, "expect_tones")) {
+		int n = 0;
+		for (uint16_t i = tones_seen; i != sim_tones; i++) {
+			if (sim_tone[i % SIM_TONE_LOG].cs) n++;
+		}
+		tones_seen = sim_tones;
+		snprintf(buf, sizeof(buf), "%d", n);
+		if (n != atoi(arg)) fail("%s tones, expected %s", buf, arg);
+	} else if (!strcmp(cmd, "expect_uart")) {
+		const char *want = quoted(arg);
+		char *out = sim_uart_tx + uart_seen;
+		char *hit;
+		sim_uart_tx[sim_uart_txlen < sizeof(sim_uart_tx) ? sim_uart_txlen : sizeof(sim_uart_tx) - 1] = 0;
+		if (!(hit = strstr(out, want))) {
+			fail("console output lacks \"%s\"%s", want, "");
+		} else {
+			char *nl = strchr(hit, '\n');
+			uart_seen = (uint16_t)((nl ? nl + 1 : hit + strlen(hit)) - sim_uart_tx);
+		}
+	} else {
+		return 0;
+	}
+	checks++;
+	return 1;
+}
+
+// 端末との中継（5msごと）：実時間を待ってから受信文字をUSART0へ、送信された文字を端末へ
+static void tty_poll(void) {
+	struct timespec now;
+	char buf[64];
+	ssize_t n;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double ahead = sim_now / (double)SIM_SEC - (now.tv_sec - wall0.tv_sec) - (now.tv_nsec - wall0.tv_nsec) / 1e9;
+	if (ahead > 0) usleep((useconds_t)(ahead * 1e6));
+	while ((n = read(tty, buf, sizeof(buf))) > 0) sim_uart_rx(buf, (uint16_t)n);
+	if (sim_uart_txlen && write(tty, sim_uart_tx, sim_uart_txlen) < 0) perror("tty");
+	sim_uart_txlen = 0; // 端末へ送った分は捨てる（expect_uartとは併用しない）
+	uart_seen = 0;
+	sim_script(sim_now + 5 * SIM_MS, tty_poll);
+}
+
+static void tty_open(const char *p) {
+	struct termios tio;
+	tty = open(p, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (tty < 0 || tcgetattr(tty, &tio) < 0) {
+		perror(p);
+		exit(2);
+	}
+	cfmakeraw(&tio);
+	tcsetattr(tty, TCSANOW, &tio);
+}
+
+// 次の行を実行（時間が要るコマンドは再開時刻を登録して戻る）
+static void step(void) {
+	if (pressing) { // press：離して50ms後に次へ
+		pressing = 0;
+		sim_switch(0);
+		sim_script(sim_now + 50 * SIM_MS, step);
+		return;
+	}
+	while (pc < nline) {
+		char cmd[32] = "", *arg;
+		char *s = line[pc++];
+		if (sscanf(s, "%31s", cmd) != 1 || cmd[0] == '#') continue;
+		arg = s + strspn(s, " \t");
+		arg += strlen(cmd);
+		arg += strspn(arg, " \t");
+		if (verbose) printf("%10.3f  %s\n", sim_now / (double)SIM_SEC, s);
+
+		if (check(cmd, arg)) continue;
+		if (!strcmp(cmd, "run")) {
+			sim_script(sim_now + duration(arg), step);
+			return;
+		} else if (!strcmp(cmd, "press")) {
+			char sw[8] = "", t[16] = "";
+			sscanf(arg, "%7s %15s", sw, t);
+			pressing = switches(sw);
+			sim_switch(pressing);
+			sim_script(sim_now + duration(t), step);
+			return;
+		} else if (!strcmp(cmd, "rtc")) {
+			rtc_cmd(arg);
+		} else if (!strcmp(cmd, "uart")) {
+			char buf[64];
+			snprintf(buf, sizeof(buf), "%s\r", quoted(arg));
+			sim_uart_rx(buf, (uint16_t)strlen(buf));
+		} else if (!strcmp(cmd, "print")) {
+			print_display();
+		} else {
+			fail("unknown command \"%s\"%s", cmd, "");
+		}
+	}
+#if PROF_STATS
+	prof_report();
+#endif
+	printf("%s: %d checks, %d failed\n", path, checks, fails);
+	exit(fails ? 1 : 0);
+}
+
+static void load(const char *p) {
+	static char buf[65536];
+	FILE *f = fopen(p, "r");
+	if (!f) {
+		perror(p);
+		exit(2);
+	}
+	size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+	fclose(f);
+	buf[n] = 0;
+	line = calloc(n + 1, sizeof(char *));
+	for (char *s = strtok(buf, "\n"); s; s = strtok(0, "\n")) {
+		s[strcspn(s, "\r")] = 0;
+		line[nline++] = s;
+	}
+}
+
+int main(int argc, char **argv) {
+	uint8_t fresh = 0;
+	sim_time_t phase = 500 * SIM_MS;
+	char time[16] = "250101000000";
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-v")) verbose = 1;
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc) tty_open(argv[++i]);
+		else path = argv[i];
+	}
+	if (!path) {
+		fprintf(stderr, "usage: sim [-v] [-t tty] scenario.sim\n");
+		return 2;
+	}
+	load(path);
+
+	// boot前：RTCとクロックの条件
+	while (pc < nline) {
+		char cmd[32] = "", arg[64] = "";
+		char *s = line[pc++];
+		if (sscanf(s, "%31s %63s", cmd, arg) < 1 || cmd[0] == '#') continue;
+		if (!strcmp(cmd, "boot")) break;
+		if (!strcmp(cmd, "rtc")) snprintf(time, sizeof(time), "%s", arg);
+		else if (!strcmp(cmd, "rtc_fresh")) fresh = 1;
+		else if (!strcmp(cmd, "rtc_phase")) phase = duration(arg);
+		else if (!strcmp(cmd, "cpu_ppm")) sim_cfg.cpu_ppm = atof(arg);
+		else if (!strcmp(cmd, "rtc_ppm")) sim_cfg.rtc_ppm = atof(arg);
+		else fail("unknown command before boot \"%s\"%s", cmd, "");
+	}
+	rtc8564_init(fresh, phase);
+	if (!fresh) rtc_cmd(time);
+	sim_script(0, step);
+	if (tty >= 0) {
+		clock_gettime(CLOCK_MONOTONIC, &wall0);
+		sim_script(0, tty_poll);
+	}
+	firmware_main();
+	return 2;
+}
\ No newline at end of file
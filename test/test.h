@@ -0,0 +1,33 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+// ユニットテスト（unit/test_*.c）の確認：失敗は位置と式を表示して数え、最後にtest_doneで集計する
+
+static int test_checks, test_fails;
+
+#define CHECK(c) do { \
+	test_checks++; \
+	if (!(c)) { \
+		test_fails++; \
+		fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); \
+	} \
+} while (0)
+
+// 値の比較（失敗時に両方の値を表示）
+#define CHECK_EQ(a, b) do { \
+	long long a_ = (long long)(a), b_ = (long long)(b); \
+	test_checks++; \
+	if (a_ != b_) { \
+		test_fails++; \
+		fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, a_, b_); \
+	} \
+} while (0)
+
+static inline int test_done(const char *name) {
+	printf("%s: %d checks, %d failed\n", name, test_checks, test_fails);
+	return test_fails ? 1 : 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include <math.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "config.h"
+#include "buzzer.h"
+#include "timer.h"
+#include "sim.h"
+#include "test.h"
+
+// buzzer.cが書くOCR0A/TCCR0Bの列（音程と切り替え時刻）を期待する周波数・音長と比べる
+// 音程表はF_CPUからコンパイル時に計算するため、MakefileでF_CPUを変えて（1/8/20MHz）同じテストをビルドする
+
+ISR(TIMER1_COMPA_vect) {
+	timer_tick();
+}
+
+static const uint32_t note_hz[NOTE_NUM] = {
+	0, 1047, 1175, 1319, 1397, 1568, 1760, 1976, 2093, 2349, 2637, 2794, 3136, 3520, 3951, 4186, BUZZER_BEEP_HZ
+};
+
+static const buz_note_t scale[] PROGMEM = {
+	{NOTE_C6, 1}, {NOTE_D6, 1}, {NOTE_E6, 1}, {NOTE_F6, 1}, {NOTE_G6, 1}, {NOTE_A6, 1}, {NOTE_B6, 1},
+	{NOTE_C7, 1}, {NOTE_D7, 1}, {NOTE_E7, 1}, {NOTE_F7, 1}, {NOTE_G7, 1}, {NOTE_A7, 1}, {NOTE_B7, 1},
+	{NOTE_C8, 1}, {NOTE_BEEP, 1}, {0, 0}
+};
+
+static uint16_t prescaler(uint8_t cs) {
+	static const uint16_t div[6] = {0, 1, 8, 64, 256, 1024};
+	return cs < 6 ? div[cs] : 0;
+}
+
+// CTC＋トグルの出力周波数
+static double tone_hz(uint8_t ocr, uint8_t cs) {
+	return F_CPU / (2.0 * prescaler(cs) * (ocr + 1));
+}
+
+// 1ms（Timer1の1周期）の実時間
+static sim_time_t tick_ps(void) {
+	return sim_cycles((OCR1A + 1UL) * prescaler(TCCR1B & 7));
+}
+
+// 全音程：プリスケーラはOCR0Aが8bitに収まる最小（分解能が最も高い）で、半周期カウントは最も近い整数
+// （誤差は半周期カウントの丸めのみ、1MHzのA6（/8で35.5カウント）で最大1.4%）
+static void test_pitch(void) {
+	uint16_t first = sim_tones;
+
+	buzzer_play(scale);
+	for (uint8_t i = 1; i < NOTE_NUM; i++) {
+		const sim_tone_t *t = &sim_tone[(first + i - 1) % SIM_TONE_LOG];
+		CHECK_EQ(OCR0A, t->ocr);
+		CHECK_EQ(TCCR0B, t->cs);
+		CHECK_EQ(TCCR0A, (1 << COM0A0) | (1 << WGM01));
+		CHECK(prescaler(t->cs) != 0);
+		double half = F_CPU / (2.0 * prescaler(t->cs) * note_hz[i]);
+		double hz = tone_hz(t->ocr, t->cs), err = fabs(hz / note_hz[i] - 1);
+		if (fabs(half - (t->ocr + 1)) > 0.5 || err > 0.015) {
+			fprintf(stderr, "  note %u: %.1f Hz for %u Hz (OCR0A=%u, CS=%u)\n", i, hz, note_hz[i], t->ocr, t->cs);
+		}
+		CHECK(fabs(half - (t->ocr + 1)) <= 0.5);
+		CHECK(err <= 0.015);
+		if (t->cs > 1) CHECK(F_CPU / (2.0 * prescaler(t->cs - 1) * note_hz[i]) > 256.5); // 1段小さい分周では収まらない
+		sim_run(BUZ_UNIT_MS * tick_ps());
+		CHECK_EQ(sim_tones - first, i + 1);
+	}
+	sim_run(5 * SIM_MS);
+	CHECK_EQ(sim_tones - first, NOTE_NUM); // 最後に停止
+	CHECK_EQ(sim_tone[(sim_tones - 1) % SIM_TONE_LOG].cs, 0);
+	CHECK_EQ(TCCR0B, 0);
+	CHECK_EQ(TCCR0A, 0);
+}
+
+// アラーム：音と休符の切り替え時刻が音長どおり、終端で停止
+static void test_schedule(void) {
+	static const uint8_t want[][2] = { // 音名、音長（BUZ_UNIT_MS単位）
+		{NOTE_C7, 10}, {NOTE_E7, 10}, {NOTE_G7, 10}, {NOTE_C8, 20}, {NOTE_REST, 30},
+		{NOTE_C7, 10}, {NOTE_E7, 10}, {NOTE_G7, 10}, {NOTE_C8, 20}, {NOTE_REST, 30},
+		{NOTE_C7, 10}, {NOTE_E7, 10}, {NOTE_G7, 10}, {NOTE_C8, 40}
+	};
+	const uint8_t n = sizeof(want) / sizeof(want[0]);
+	uint16_t first = sim_tones;
+	sim_time_t t0 = sim_now, at = 0;
+
+	buzzer_play(mel_alarm);
+	sim_run(2500 * SIM_MS);
+	CHECK_EQ(sim_tones - first, n + 1);
+	for (uint8_t i = 0; i <= n; i++) {
+		const sim_tone_t *t = &sim_tone[(first + i) % SIM_TONE_LOG];
+		double late = ((double)(t->t - t0) - (double)at * tick_ps()) / SIM_US;
+		CHECK(fabs(late) < 1000.0); // 1ms刻み（Timer1）の位相差のみ
+		if (i == n || want[i][0] == NOTE_REST) {
+			CHECK_EQ(t->cs, 0);
+		} else {
+			CHECK(fabs(tone_hz(t->ocr, t->cs) / note_hz[want[i][0]] - 1) <= 0.015);
+		}
+		if (i < n) at += want[i][1] * BUZ_UNIT_MS;
+	}
+	CHECK_EQ(at, 2300);
+
+	// 再生中の再生要求は打ち切って最初から
+	first = sim_tones;
+	buzzer_play(mel_alarm);
+	sim_run(150 * SIM_MS);
+	buzzer_play(mel_beep1);
+	sim_run(100 * SIM_MS);
+	CHECK_EQ(sim_tones - first, 4); // C7、E7、ビープ、停止
+	CHECK(fabs(tone_hz(sim_tone[(first + 2) % SIM_TONE_LOG].ocr, sim_tone[(first + 2) % SIM_TONE_LOG].cs) / BUZZER_BEEP_HZ - 1) <= 0.015);
+	CHECK_EQ(sim_tone[(first + 3) % SIM_TONE_LOG].cs, 0);
+	CHECK_EQ(TCCR0B, 0);
+}
+
+int main(void) {
+	TCCR1B = (1 << WGM12) | T1_CS;
+	OCR1A = T1_OCR;
+	TIMSK1 = (1 << OCIE1A);
+	sei();
+	sim_run(SIM_MS / 2);
+
+	test_pitch();
+	test_schedule();
+	char name[40];
+	snprintf(name, sizeof(name), "test_buzzer (F_CPU=%lu)", (unsigned long)F_CPU);
+	return test_done(name);
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <string.h>
+#include <time.h>
+#include "clock.h"
+#include "test.h"
+
+// clock_tickの暦（2000?2099年）を基準の暦（gmtime）と比べる
+//   全日：毎日23:59:58から3秒進めて日・月・年の繰り上がりを確認
+//   全秒：うるう年を含む2年間（2023?2024年）を1秒ずつ進めて一致し続けること
+
+#define EPOCH_2000 946684800LL // 2000-01-01 00:00:00 UTC
+
+static uint8_t bcd(int v) {
+	return (uint8_t)(((v / 10) << 4) | (v % 10));
+}
+
+// 基準の暦（2000年からの秒数）をBCD時刻へ
+static void ref_time(long long s, bcdtime_t *t) {
+	time_t u = (time_t)(EPOCH_2000 + s);
+	struct tm tm;
+	gmtime_r(&u, &tm);
+	t->sec = bcd(tm.tm_sec);
+	t->min = bcd(tm.tm_min);
+	t->hour = bcd(tm.tm_hour);
+	t->day = bcd(tm.tm_mday);
+	t->month = bcd(tm.tm_mon + 1);
+	t->year = bcd(tm.tm_year % 100);
+}
+
+static int same(const bcdtime_t *a, const bcdtime_t *b) {
+	return a->sec == b->sec && a->min == b->min && a->hour == b->hour &&
+		a->day == b->day && a->month == b->month && a->year == b->year;
+}
+
+static void report(long long s, const bcdtime_t *got, const bcdtime_t *want) {
+	fprintf(stderr, "  at %lld s: got 20%02X-%02X-%02X %02X:%02X:%02X, expected 20%02X-%02X-%02X %02X:%02X:%02X\n", s,
+		got->year, got->month, got->day, got->hour, got->min, got->sec,
+		want->year, want->month, want->day, want->hour, want->min, want->sec);
+}
+
+// 2000?2099年の毎日の日付の繰り上がり（最後は2099-12-31→00年、年は下2桁のみ）
+static void test_days(void) {
+	bcdtime_t t, want;
+	int bad = 0;
+
+	for (long long day = 0; day < 36525 && bad < 5; day++) {
+		long long s = day * 86400 + 86398;
+		ref_time(s, &t);
+		clock_put(&t);
+		for (int i = 1; i <= 3; i++) {
+			clock_tick();
+			clock_get(&t);
+			ref_time(s + i, &want);
+			if (!same(&t, &want)) {
+				report(s + i, &t, &want);
+				bad++;
+				break;
+			}
+		}
+	}
+	CHECK_EQ(bad, 0);
+
+	// 2月末（うるう年と平年）
+	t = (bcdtime_t){0x59, 0x59, 0x23, 0x28, 0x02, 0x24};
+	clock_put(&t);
+	clock_tick();
+	clock_get(&t);
+	CHECK_EQ(t.day, 0x29);
+	CHECK_EQ(t.month, 0x02);
+	t = (bcdtime_t){0x59, 0x59, 0x23, 0x28, 0x02, 0x25};
+	clock_put(&t);
+	clock_tick();
+	clock_get(&t);
+	CHECK_EQ(t.day, 0x01);
+	CHECK_EQ(t.month, 0x03);
+}
+
+// 2023?2024年を1秒ずつ：秒以外の桁は分の繰り上がりのときだけ基準と照合
+static void test_seconds(void) {
+	long long s0 = (365LL * 23 + 6) * 86400, end = s0 + (365LL + 366) * 86400; // 2023-01-01、2000?2022年のうるう年は6回
+	bcdtime_t t, want;
+	int bad = 0;
+
+	ref_time(s0, &t);
+	CHECK_EQ(t.year, 0x23);
+	CHECK_EQ(t.month, 0x01);
+	CHECK_EQ(t.day, 0x01);
+	clock_put(&t);
+	for (long long s = s0 + 1; s <= end && bad < 5; s++) {
+		bcdtime_t prev = t;
+		clock_tick();
+		clock_get(&t);
+		if (s % 60) {
+			prev.sec = bcd((int)(s % 60));
+			if (!same(&t, &prev)) {
+				report(s, &t, &prev);
+				bad++;
+			}
+		} else {
+			ref_time(s, &want);
+			if (!same(&t, &want)) {
+				report(s, &t, &want);
+				bad++;
+			}
+		}
+	}
+	CHECK_EQ(bad, 0);
+	CHECK_EQ(t.year, 0x25);
+	CHECK_EQ(t.month, 0x01);
+	CHECK_EQ(t.day, 0x01);
+	CHECK_EQ(t.hour, 0x00);
+}
+
+int main(void) {
+	test_days();
+	test_seconds();
+	return test_done("test_clock");
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "clock.h"
+#include "test.h"
+
+// clock_get/clock_putを実際の割込み（SIGALRM）で任意の命令の間に割り込ませ、読み出しが途中の値を見ないことを確認する
+//   割込み：1?3回続けてclock_put（2回なら読み出し中のバッファそのものを書き換える）
+//   メイン：clock_getを繰り返し、ときどきclock_put（書き込み側同士の直列化はATOMIC_BLOCK＝シグナルの禁止）
+// 書き込む時刻は全項目を同じ通し番号にし、読み出した項目がそろっていて番号が戻らないことを確認する
+// sim.cはリンクせず、Iフラグ（sim_cli/sim_sei）はここでシグナルのマスクとして持つ
+
+#define INTERRUPTS 20000
+
+volatile uint8_t sim_sreg_i = 1;
+static sigset_t alrm;
+static volatile uint32_t serial;     // 書き込んだ通し番号（下位8bitを各項目に）
+static volatile uint32_t isr_count;
+static uint32_t rnd = 12345;
+
+void sim_cli(void) {
+	sigprocmask(SIG_BLOCK, &alrm, 0);
+	sim_sreg_i = 0;
+}
+
+void sim_sei(void) {
+	sim_sreg_i = 1;
+	sigprocmask(SIG_UNBLOCK, &alrm, 0);
+}
+
+static uint32_t xorshift(void) {
+	rnd ^= rnd << 13;
+	rnd ^= rnd >> 17;
+	rnd ^= rnd << 5;
+	return rnd;
+}
+
+// 次の割込みを20?150us後に
+static void arm(void) {
+	struct itimerval it = {{0, 0}, {0, (suseconds_t)(20 + xorshift() % 131)}};
+	setitimer(ITIMER_REAL, &it, 0);
+}
+
+// 書き込み側は割込み禁止の中で番号を取るので、公開される番号は増える一方
+static void put_next(void) {
+	bcdtime_t t;
+	uint8_t v = (uint8_t)++serial;
+	memset(&t, v, sizeof(t));
+	clock_put(&t);
+}
+
+static void isr(int sig) {
+	sim_sreg_i = 0;
+	for (uint32_t n = 1 + xorshift() % 3; n; n--) put_next();
+	isr_count++;
+	arm();
+	sim_sreg_i = 1;
+}
+
+int main(void) {
+	struct sigaction sa;
+	bcdtime_t t;
+	uint32_t reads = 0, torn = 0, back = 0;
+	uint8_t last;
+
+	sigemptyset(&alrm);
+	sigaddset(&alrm, SIGALRM);
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = isr;
+	sigaction(SIGALRM, &sa, 0);
+
+	sim_cli();
+	put_next();
+	sim_sei();
+	last = (uint8_t)serial;
+	arm();
+
+	while (isr_count < INTERRUPTS) {
+		clock_get(&t);
+		reads++;
+		const uint8_t *b = (const uint8_t *)&t;
+		for (uint8_t i = 1; i < sizeof(t); i++) {
+			if (b[i] != b[0]) {
+				torn++;
+				break;
+			}
+		}
+		if ((uint8_t)(b[0] - last) >= 0x80) back++; // 8bitの通し番号が戻った
+		last = b[0];
+		if (reads % 64 == 0) {
+			put_next();
+			clock_get(&t);
+			last = t.sec;
+		}
+	}
+	setitimer(ITIMER_REAL, &(struct itimerval){{0, 0}, {0, 0}}, 0);
+
+	CHECK_EQ(torn, 0);
+	CHECK_EQ(back, 0);
+	CHECK(reads > INTERRUPTS);
+	return test_done("test_clock_preempt");
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+#define _XOPEN_SOURCE 600
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "test.h"
+
+// USART0コンソール（UART_CONSOLE=1）をptyから操作する：シリアル端末と同じく1行送って応答を読む
+// 相手はbuild/sim_uart（ファームウェア全体＋RTCモデル、実時間で動作）、シナリオはunit/test_console.sim
+
+static int pty = -1;
+static pid_t child;
+static char rxbuf[1024];
+static size_t rxlen;
+
+static double now_s(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void sleep_ms(int ms) {
+	usleep((useconds_t)ms * 1000);
+}
+
+static void send(const char *cmd) {
+	char buf[64];
+	int n = snprintf(buf, sizeof(buf), "%s\r", cmd);
+	if (write(pty, buf, (size_t)n) != n) perror("pty");
+}
+
+// 1行受信（CR LFを除く）、timeout_ms以内に来なければ0
+static int recv_line(char *line, size_t size, int timeout_ms) {
+	double end = now_s() + timeout_ms / 1000.0;
+	for (;;) {
+		char *nl = memchr(rxbuf, '\n', rxlen);
+		if (nl) {
+			size_t n = (size_t)(nl - rxbuf) + 1;
+			size_t k = n - 1;
+			if (k && rxbuf[k - 1] == '\r') k--;
+			if (k >= size) k = size - 1;
+			memcpy(line, rxbuf, k);
+			line[k] = 0;
+			memmove(rxbuf, rxbuf + n, rxlen - n);
+			rxlen -= n;
+			return 1;
+		}
+		int left = (int)((end - now_s()) * 1000);
+		struct pollfd p = {pty, POLLIN, 0};
+		if (left <= 0 || poll(&p, 1, left) <= 0) return 0;
+		ssize_t r = read(pty, rxbuf + rxlen, sizeof(rxbuf) - rxlen);
+		if (r <= 0) return 0;
+		rxlen += (size_t)r;
+	}
+}
+
+// コマンドを送って応答1行を確認（'_'は任意の1文字）
+static void command(const char *cmd, const char *want, int line) {
+	char got[128];
+	int ok;
+
+	send(cmd);
+	test_checks++;
+	if (!recv_line(got, sizeof(got), 500)) {
+		test_fails++;
+		fprintf(stderr, "%s:%d: \"%s\": no reply, expected \"%s\"\n", __FILE__, line, cmd, want);
+		return;
+	}
+	ok = strlen(got) == strlen(want);
+	for (size_t i = 0; ok && want[i]; i++) ok = (want[i] == '_' || want[i] == got[i]);
+	if (!ok) {
+		test_fails++;
+		fprintf(stderr, "%s:%d: \"%s\": reply \"%s\", expected \"%s\"\n", __FILE__, line, cmd, got, want);
+	}
+}
+#define COMMAND(cmd, want) command(cmd, want, __LINE__)
+
+static void start(void) {
+	const char *slave;
+
+	pty = posix_openpt(O_RDWR | O_NOCTTY);
+	if (pty < 0 || grantpt(pty) || unlockpt(pty) || !(slave = ptsname(pty))) {
+		perror("pty");
+		exit(2);
+	}
+	child = fork();
+	if (child == 0) {
+		execl("build/sim_uart", "sim_uart", "-t", slave, "unit/test_console.sim", (char *)0);
+		perror("build/sim_uart");
+		_exit(2);
+	}
+	sleep_ms(300); // 起動（RTCの読み出し）
+}
+
+static void stop(void) {
+	int st;
+	kill(child, SIGTERM);
+	waitpid(child, &st, 0);
+}
+
+int main(void) {
+	char line[128];
+
+	start();
+
+	// 起動時の時刻（シナリオのrtc、最初の秒は起動0.5秒後）
+	COMMAND("R", "R 2506091534__");
+
+	// S：RTCを止めて書き込み、Gで再開した1秒後に最初の秒が進む
+	COMMAND("S 250609152959", "OK");
+	COMMAND("R", "R 250609152959");
+	sleep_ms(700);
+	COMMAND("R", "R 250609152959"); // 停止中
+	COMMAND("G", "OK");
+	sleep_ms(600);
+	COMMAND("R", "R 250609152959");
+	sleep_ms(600);
+	COMMAND("R", "R 250609153000");
+	COMMAND("G", "ERR"); // 停止していない
+
+	// Gが来なければ2秒で自動再開
+	COMMAND("S 251231235958", "OK");
+	sleep_ms(3300);
+	COMMAND("R", "R 251231235959");
+	sleep_ms(1000);
+	COMMAND("R", "R 260101000000");
+
+	// 不正な時刻・書式
+	COMMAND("S 251301000000", "ERR");
+	COMMAND("S 2506091530", "ERR");
+	COMMAND("S 2506091530000", "ERR");
+	COMMAND("X", "ERR");
+
+	// 設定
+	COMMAND("P 00", "P 00 01");
+	COMMAND("P 00 00", "P 00 00");
+	COMMAND("P 00", "P 00 00");
+	COMMAND("P 00 02", "ERR");
+	COMMAND("P 01 05", "P 01 05");
+	COMMAND("P 12 03", "P 12 03");
+	COMMAND("P 17 01", "ERR");
+	COMMAND("P 05", "ERR");
+	COMMAND("P 20", "P 20 00"); // ユーザーアラーム（既定は無効）
+	COMMAND("P 31 45", "P 31 45");
+	COMMAND("P 21 87", "P 21 87");
+	COMMAND("P 21", "P 21 87");
+	COMMAND("P 21 24", "ERR");
+	COMMAND("P 31 5A", "ERR");
+	COMMAND("P 24 00", "ERR");
+	COMMAND("P 34", "ERR");
+
+	// 統計：I2Cエラー・バス復旧と取りこぼしなし
+	COMMAND("Q", "Q I2C 00 00 00 00 00");
+	test_checks++;
+	if (!recv_line(line, sizeof(line), 500) || strcmp(line, "Q LOST 00 00 00 00")) {
+		test_fails++;
+		fprintf(stderr, "%s:%d: stats \"%s\"\n", __FILE__, __LINE__, line);
+	}
+	test_checks++;
+	if (!recv_line(line, sizeof(line), 500) || strcmp(line, "Q END")) {
+		test_fails++;
+		fprintf(stderr, "%s:%d: stats end \"%s\"\n", __FILE__, __LINE__, line);
+	}
+
+	stop();
+	return test_done("test_console");
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <math.h>
+#include "sim.h"
+#include "test.h"
+
+// 多重化の輝度：減光段数（昼・夜）と桁ごとの減光の組み合わせで、各桁のCOMの点灯率（実測）を確認する
+// 点灯率はCOMピンがHIGHの時間（sim_com_time）を多重化の整数フレーム分の窓で積算する
+// mux_on[]・dim_now・dim_trim・bright_updateはmain.cのstaticのため、main.cはここで取り込む
+
+#define main firmware_main
+#include "main.c"
+#undef main
+
+#define FRAMES 20
+#define SLOT_COUNT (T2_OCR + 1) // スロットのTimer2カウント
+
+// レベル0?7の点灯率（スロットに対して、f/256）
+static const uint16_t level_f[BRIGHT_MAX + 1] = {23, 32, 45, 64, 91, 128, 181, 256};
+
+static sim_time_t frame(void) {
+	return sim_cycles(7UL * SLOT_COUNT * T2_DIV);
+}
+
+// 各桁の点灯率（表示期間全体に対して）
+static void measure(double duty[7]) {
+	sim_time_t t0[7];
+	uint32_t n0, isr = 0;
+
+	sim_run(frame()); // 新しい点灯時間が全スロットに行き渡る
+	for (uint8_t i = 0; i < 7; i++) isr += (mux_img[i][3] > T2_OCR) ? 1 : 2;
+	for (uint8_t p = 0; p < 7; p++) t0[p] = sim_com_time(p);
+	n0 = sim_isr_count[SIM_T2A] + sim_isr_count[SIM_T2B];
+	sim_run(FRAMES * frame());
+	for (uint8_t p = 0; p < 7; p++) duty[p] = (double)(sim_com_time(p) - t0[p]) / (FRAMES * frame());
+	// 割込みはスロット毎に開始と消灯の2回、最大輝度のスロットは比較Bが一致せず開始の1回
+	CHECK_EQ(sim_isr_count[SIM_T2A] + sim_isr_count[SIM_T2B] - n0, isr * FRAMES);
+}
+
+// 全段数×桁ごとの減光（桁iはi%4段）で、点灯率がレベルの表どおり（カウントの丸め分まで）
+static void test_levels(void) {
+	double duty[7];
+
+	dim_trim = 0;
+	for (uint8_t i = 0; i < 7; i++) dim_trim |= (uint16_t)(i % 4) << (i * 2);
+	for (uint8_t d = 0; d <= BRIGHT_MAX + 1; d++) {
+		dim_now = d;
+		for (uint8_t i = 0; i < 7; i++) mux_render(i);
+		measure(duty);
+		for (uint8_t i = 0; i < 7; i++) {
+			uint8_t dim = d + i % 4;
+			uint8_t level = dim > BRIGHT_MAX ? 0 : BRIGHT_MAX - dim;
+			double want = level_f[level] / 256.0 / 7;
+			if (fabs(duty[i] - want) > 0.5 / SLOT_COUNT / 7 + 1e-9) {
+				fprintf(stderr, "  dim %u + trim %u: slot %u duty %.4f, expected %.4f\n", d, i % 4, i, duty[i], want);
+			}
+			CHECK(fabs(duty[i] - want) <= 0.5 / SLOT_COUNT / 7 + 1e-9);
+		}
+	}
+
+	// 最大輝度（減光なし）と夜間の既定（5段）の平均電流比
+	double full = 0, night5 = 0;
+	dim_trim = 0;
+	dim_now = 0;
+	for (uint8_t i = 0; i < 7; i++) mux_render(i);
+	measure(duty);
+	for (uint8_t i = 0; i < 7; i++) full += duty[i];
+	CHECK(fabs(full - 1.0) < 1e-6); // 常にどれか1桁が点灯
+	dim_now = 5;
+	for (uint8_t i = 0; i < 7; i++) mux_render(i);
+	measure(duty);
+	for (uint8_t i = 0; i < 7; i++) night5 += duty[i];
+	CHECK(night5 < 0.2);
+}
+
+// 時間帯：夜間は開始時から終了時の前まで（日付をまたぐ・またがない・夜間なし）
+static void test_schedule(void) {
+	static const struct {
+		uint8_t on, off, hour, night;
+	} c[] = {
+		{0x22, 0x06, 0x21, 0}, {0x22, 0x06, 0x22, 1}, {0x22, 0x06, 0x00, 1}, {0x22, 0x06, 0x05, 1},
+		{0x22, 0x06, 0x06, 0}, {0x01, 0x05, 0x00, 0}, {0x01, 0x05, 0x01, 1}, {0x01, 0x05, 0x05, 0},
+		{0x07, 0x07, 0x07, 0}, {0x07, 0x07, 0x12, 0}
+	};
+	bcdtime_t t = {0};
+	double duty[7];
+
+	dim_set = 0x61; // 昼1段、夜6段
+	dim_trim = 0;
+	for (uint8_t k = 0; k < sizeof(c) / sizeof(c[0]); k++) {
+		night[0] = c[k].on;
+		night[1] = c[k].off;
+		t.hour = c[k].hour;
+		clock_put(&t);
+		dim_now = 0xFF;
+		bright_update();
+		CHECK_EQ(dim_now, c[k].night ? 6 : 1);
+		measure(duty);
+		CHECK(fabs(duty[3] - level_f[c[k].night ? 1 : 6] / 256.0 / 7) <= 0.5 / SLOT_COUNT / 7 + 1e-9);
+	}
+}
+
+int main(void) {
+	hal_init();
+	for (uint8_t i = 0; i < 7; i++) {
+		seg[i] = SEG_DASH;
+		mux_render(i);
+	}
+	hal_mux_start();
+	sei();
+
+	test_levels();
+	test_schedule();
+	return test_done("test_duty");
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "config.h"
+#include "i2c.h"
+#include "rtc.h"
+#include "sim.h"
+#include "rtc8564.h"
+#include "test.h"
+
+// i2c.cの非同期転送キューと同期APIを、TWIレジスタのモデル（sim.c）とRTC-8564のモデルで確認する
+
+// 転送の監視はファームウェアと同じくTimer1（1ms）から
+ISR(TIMER1_COMPA_vect) {
+	i2c_tick();
+}
+
+static uint8_t order[8], norder;
+
+static void record(i2c_xfer_t *x) {
+	order[norder++] = x->reg;
+}
+
+// 転送の完了待ち（割込みで進める）
+static void wait(i2c_xfer_t *x) {
+	sim_time_t end = sim_now + 1000 * SIM_MS;
+	while (x->status == I2C_BUSY && sim_now < end) sim_idle();
+}
+
+// 非同期：書き込みと読み出しの往復、RTCのレジスタに書かれること
+static void test_write_read(void) {
+	uint8_t w[3] = {0x30, 0x12, 0x05}, r[3] = {0};
+	i2c_xfer_t xw = {0xA2, 0x09, I2C_WRITE, 3, w, 0, 0};
+	i2c_xfer_t xr = {0xA2, 0x09, I2C_READ, 3, r, 0, 0};
+
+	CHECK_EQ(i2c_submit(&xw), 0);
+	CHECK_EQ(i2c_submit(&xr), 0);
+	CHECK_EQ(xw.status, I2C_BUSY);
+	wait(&xr);
+	CHECK_EQ(xw.status, I2C_DONE);
+	CHECK_EQ(xr.status, I2C_DONE);
+	CHECK_EQ(rtc8564_reg[0x09], 0x30);
+	CHECK_EQ(rtc8564_reg[0x0A], 0x12);
+	CHECK_EQ(rtc8564_reg[0x0B], 0x05);
+	CHECK(!memcmp(r, w, sizeof(r)));
+	CHECK(i2c_idle());
+}
+
+// 非同期：投入順に実行・通知、満杯（7件待機）と二重投入・長さ0は拒否
+static void test_queue(void) {
+	uint8_t buf[I2C_QUEUE_LEN][1];
+	i2c_xfer_t x[I2C_QUEUE_LEN];
+
+	norder = 0;
+	for (uint8_t i = 0; i < I2C_QUEUE_LEN; i++) {
+		x[i] = (i2c_xfer_t){0xA2, (uint8_t)(0x09 + i % 4), I2C_READ, 1, buf[i], record, 0};
+	}
+	for (uint8_t i = 0; i < I2C_QUEUE_LEN - 1; i++) CHECK_EQ(i2c_submit(&x[i]), 0);
+	CHECK_EQ(i2c_submit(&x[I2C_QUEUE_LEN - 1]), -1); // 満杯
+	CHECK_EQ(x[I2C_QUEUE_LEN - 1].status, 0);
+	CHECK_EQ(i2c_submit(&x[0]), -1);                  // 投入済み
+
+	i2c_xfer_t empty = {0xA2, 0x02, I2C_READ, 0, buf[0], 0, 0};
+	CHECK_EQ(i2c_submit(&empty), -1);
+
+	wait(&x[I2C_QUEUE_LEN - 2]);
+	CHECK_EQ(norder, I2C_QUEUE_LEN - 1);
+	for (uint8_t i = 0; i < norder; i++) CHECK_EQ(order[i], 0x09 + i % 4);
+	for (uint8_t i = 0; i < I2C_QUEUE_LEN - 1; i++) CHECK_EQ(x[i].status, I2C_DONE);
+	CHECK(i2c_idle());
+
+	// 完了した要求は再投入できる
+	CHECK_EQ(i2c_submit(&x[0]), 0);
+	wait(&x[0]);
+	CHECK_EQ(x[0].status, I2C_DONE);
+}
+
+// 同期API：書き込みとリピートスタートでの読み出し
+static void test_sync(void) {
+	int a, b, c;
+
+	CHECK_EQ(i2c_start(0xA2), 0);
+	CHECK_EQ(i2c_send(0x0E), 0);
+	CHECK_EQ(i2c_send(0x82), 0);
+	CHECK_EQ(i2c_send(0x05), 0);
+	i2c_stop();
+	CHECK_EQ(rtc8564_reg[0x0E], 0x82);
+	CHECK_EQ(rtc8564_reg[0x0F], 0x05);
+
+	rtc8564_set(25, 6, 9, 15, 34, 56);
+	CHECK_EQ(i2c_start(0xA2), 0);
+	CHECK_EQ(i2c_send(0x02), 0);
+	CHECK_EQ(i2c_start(0xA3), 0);
+	a = i2c_recv(1);
+	b = i2c_recv(1);
+	c = i2c_recv(0);
+	i2c_stop();
+	CHECK_EQ(a, 0x56);
+	CHECK_EQ(b, 0x34);
+	CHECK_EQ(c, 0x15);
+}
+
+// 同期APIの占有中に投入した非同期転送は、i2c_stopまで始まらない（監視のタイムアウトもしない）
+static void test_locked(void) {
+	uint8_t v = 0x07;
+	i2c_xfer_t x = {0xA2, 0x0F, I2C_WRITE, 1, &v, 0, 0};
+	uint8_t timeouts = i2c_err.timeout;
+
+	CHECK_EQ(i2c_start(0xA2), 0);
+	CHECK_EQ(i2c_submit(&x), 0);
+	sim_run(50 * SIM_MS);
+	CHECK_EQ(x.status, I2C_BUSY);
+	CHECK_EQ(rtc8564_reg[0x0F], 0x05);
+	CHECK_EQ(i2c_send(0x0F), 0);
+	CHECK_EQ(i2c_send(0x06), 0);
+	i2c_stop();
+	wait(&x);
+	CHECK_EQ(x.status, I2C_DONE);
+	CHECK_EQ(rtc8564_reg[0x0F], 0x07);
+	CHECK_EQ(i2c_err.timeout, timeouts);
+}
+
+// 応答しないアドレス：非同期は再試行後にI2C_ERROR、同期はi2c_startが-1で占有を解放
+static void test_nack(void) {
+	uint8_t v = 0;
+	i2c_xfer_t x = {0xA0, 0x00, I2C_READ, 1, &v, 0, 0};
+	i2c_err_t e = i2c_err;
+
+	CHECK_EQ(i2c_submit(&x), 0);
+	wait(&x);
+	CHECK_EQ(x.status, I2C_ERROR);
+	CHECK_EQ(i2c_err.nack, e.nack + I2C_RETRIES + 1);
+	CHECK_EQ(i2c_err.fail, e.fail + 1);
+	CHECK_EQ(i2c_err.timeout, e.timeout);
+
+	CHECK_EQ(i2c_start(0xA0), -1);
+	CHECK_EQ(i2c_err.nack, e.nack + I2C_RETRIES + 2);
+
+	// 続く転送は正常に行える
+	x.adr = 0xA2;
+	x.reg = 0x0F;
+	CHECK_EQ(i2c_submit(&x), 0);
+	wait(&x);
+	CHECK_EQ(x.status, I2C_DONE);
+	CHECK_EQ(v, 0x07);
+}
+
+// rtc_write/rtc_flush：連続範囲ごとのバースト、最後の範囲がレジスタ0x0Fで終わっても送信を続けられる
+static void test_rtc_flush(void) {
+	uint32_t ops = sim_twi_ops;
+
+	rtc_write(0x0E, 0x82);
+	rtc_write(0x0F, 0x03);
+	rtc_write(0x09, 0x45);
+	rtc_flush();
+	rtc_wait();
+	CHECK_EQ(rtc8564_reg[0x09], 0x45);
+	CHECK_EQ(rtc8564_reg[0x0E], 0x82);
+	CHECK_EQ(rtc8564_reg[0x0F], 0x03);
+	CHECK_EQ(sim_twi_ops - ops, (3 + 1) + (3 + 2)); // 2バースト（START・SLA・レジスタ番号＋データ）
+
+	rtc_write(0x0F, 0x04);
+	rtc_flush();
+	rtc_wait();
+	CHECK_EQ(rtc8564_reg[0x0F], 0x04);
+	CHECK(!rtc_busy());
+}
+
+int main(void) {
+	rtc8564_init(0, 0);
+	TCCR1B = (1 << WGM12) | T1_CS;
+	OCR1A = T1_OCR;
+	TIMSK1 = (1 << OCIE1A);
+	i2c_init();
+	sei();
+
+	test_write_read();
+	test_queue();
+	test_sync();
+	test_locked();
+	test_nack();
+	test_rtc_flush();
+	return test_done("test_i2c");
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "config.h"
+#include "i2c.h"
+#include "sim.h"
+#include "rtc8564.h"
+#include "test.h"
+
+// i2c.hの最悪所要時間（非同期1件約34ms、キュー満杯約240ms、同期1回約1ms）と、
+// 障害後にバスと占有が解放されることを、TWIの障害注入（sim_twi_fault、sim_sda_stuck）で確認する
+
+ISR(TIMER1_COMPA_vect) {
+	i2c_tick();
+}
+
+static sim_time_t wait(i2c_xfer_t *x) {
+	sim_time_t t0 = sim_now, end = sim_now + 2000 * SIM_MS;
+	while (x->status == I2C_BUSY && sim_now < end) sim_idle();
+	return sim_now - t0;
+}
+
+// 応答なし：再試行を含めて34ms以内に打ち切り、毎回バスを復旧する
+static void test_hang(void) {
+	uint8_t v;
+	i2c_xfer_t x = {0xA2, 0x02, I2C_READ, 1, &v, 0, 0};
+	i2c_err_t e = i2c_err;
+	sim_time_t t;
+
+	sim_twi_fault(SIM_TWI_HANG, -1);
+	CHECK_EQ(i2c_submit(&x), 0);
+	t = wait(&x);
+	sim_twi_fault(SIM_TWI_OK, 0);
+	CHECK_EQ(x.status, I2C_ERROR);
+	CHECK(t <= 34 * SIM_MS);
+	CHECK(t >= (I2C_RETRIES + 1) * (I2C_TIMEOUT_MS - 1) * SIM_MS);
+	CHECK_EQ(i2c_err.timeout, e.timeout + I2C_RETRIES + 1);
+	CHECK_EQ(i2c_err.recover, e.recover + I2C_RETRIES + 1);
+	CHECK_EQ(i2c_err.fail, e.fail + 1);
+	CHECK(i2c_idle());
+}
+
+// 応答なしでキュー満杯（7件）：すべて打ち切られるまで240ms以内
+static void test_hang_queue(void) {
+	uint8_t v[I2C_QUEUE_LEN - 1];
+	i2c_xfer_t x[I2C_QUEUE_LEN - 1];
+	sim_time_t t;
+
+	sim_twi_fault(SIM_TWI_HANG, -1);
+	for (uint8_t i = 0; i < I2C_QUEUE_LEN - 1; i++) {
+		x[i] = (i2c_xfer_t){0xA2, 0x02, I2C_READ, 1, &v[i], 0, 0};
+		CHECK_EQ(i2c_submit(&x[i]), 0);
+	}
+	t = wait(&x[I2C_QUEUE_LEN - 2]);
+	sim_twi_fault(SIM_TWI_OK, 0);
+	CHECK(t <= 240 * SIM_MS);
+	for (uint8_t i = 0; i < I2C_QUEUE_LEN - 1; i++) CHECK_EQ(x[i].status, I2C_ERROR);
+	CHECK(i2c_idle());
+}
+
+// 1回だけの障害：再試行で成功する（バスエラーは割込みで即時、応答なしは監視で検出）
+static void test_retry(void) {
+	uint8_t v = 0;
+	i2c_xfer_t x = {0xA2, 0x0F, I2C_READ, 1, &v, 0, 0};
+	i2c_err_t e = i2c_err;
+	sim_time_t t;
+
+	rtc8564_reg[0x0F] = 0x2A;
+	sim_twi_fault(SIM_TWI_BUSERR, 1);
+	CHECK_EQ(i2c_submit(&x), 0);
+	t = wait(&x);
+	CHECK_EQ(x.status, I2C_DONE);
+	CHECK_EQ(v, 0x2A);
+	CHECK_EQ(i2c_err.bus, e.bus + 1);
+	CHECK(t < 1 * SIM_MS);
+
+	v = 0;
+	sim_twi_fault(SIM_TWI_HANG, 1);
+	CHECK_EQ(i2c_submit(&x), 0);
+	t = wait(&x);
+	CHECK_EQ(x.status, I2C_DONE);
+	CHECK_EQ(v, 0x2A);
+	CHECK_EQ(i2c_err.timeout, e.timeout + 1);
+	CHECK(t <= (I2C_TIMEOUT_MS + 2) * SIM_MS);
+	CHECK_EQ(i2c_err.fail, e.fail);
+}
+
+// スレーブがSDAをLOWに保持：STARTが出せず、監視の復旧（SCLクロック）で解放されて再試行が成功する
+static void test_sda_stuck(void) {
+	uint8_t v = 0;
+	i2c_xfer_t x = {0xA2, 0x0F, I2C_READ, 1, &v, 0, 0};
+	i2c_err_t e = i2c_err;
+
+	sim_sda_stuck = 5;
+	CHECK_EQ(i2c_submit(&x), 0);
+	wait(&x);
+	CHECK_EQ(x.status, I2C_DONE);
+	CHECK_EQ(v, 0x2A);
+	CHECK_EQ(sim_sda_stuck, 0);
+	CHECK_EQ(i2c_err.recover, e.recover + 1);
+
+	// リセット直後（i2c_init）に保持されていれば初期化で復旧する
+	sim_sda_stuck = 9;
+	i2c_init();
+	CHECK_EQ(sim_sda_stuck, 0);
+	CHECK_EQ(i2c_err.recover, e.recover + 2);
+}
+
+// 同期API：応答なしは約1msで-1、占有は解放されて待機中の非同期転送が始まる
+static void test_sync_hang(void) {
+	uint8_t v = 0;
+	i2c_xfer_t x = {0xA2, 0x0F, I2C_READ, 1, &v, 0, 0};
+	i2c_err_t e = i2c_err;
+	sim_time_t t0;
+
+	sim_twi_fault(SIM_TWI_HANG, 1);
+	t0 = sim_now;
+	CHECK_EQ(i2c_start(0xA2), -1);
+	CHECK(sim_now - t0 <= 1200 * SIM_US);
+	CHECK_EQ(i2c_err.timeout, e.timeout + 1);
+	CHECK_EQ(i2c_err.recover, e.recover + 1);
+	CHECK_EQ(i2c_submit(&x), 0);
+	wait(&x);
+	CHECK_EQ(x.status, I2C_DONE);
+
+	// 送信中の応答なし：呼び出し側はi2c_stopで解放する
+	CHECK_EQ(i2c_start(0xA2), 0);
+	sim_twi_fault(SIM_TWI_HANG, 1);
+	t0 = sim_now;
+	CHECK_EQ(i2c_send(0x0F), -1);
+	CHECK(sim_now - t0 <= 1200 * SIM_US);
+	i2c_stop();
+	x.status = 0;
+	v = 0;
+	CHECK_EQ(i2c_submit(&x), 0);
+	wait(&x);
+	CHECK_EQ(x.status, I2C_DONE);
+	CHECK_EQ(v, 0x2A);
+}
+
+int main(void) {
+	rtc8564_init(0, 0);
+	TCCR1B = (1 << WGM12) | T1_CS;
+	OCR1A = T1_OCR;
+	TIMSK1 = (1 << OCIE1A);
+	i2c_init();
+	sei();
+
+	test_hang();
+	test_hang_queue();
+	test_retry();
+	test_sda_stuck();
+	test_sync_hang();
+	return test_done("test_i2c_fault");
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <string.h>
+#include "input.h"
+#include "timer.h"
+#include "sim.h"
+#include "test.h"
+
+// 記録したスイッチ波形（チャタリングを含む）をTimer1と同じ順（timer_tick→input_tick）で1msずつ流し、
+// 出たイベントを確認する。input_tickはファームウェアと同じくサンプリング中（input_active）のみ呼び、
+// 停止中はピンの変化でPCINT1の割込みを呼んで再開する
+// 波形は空白区切りのトークン：1文字1ms（'.'なし、'1' S1、'2' S2、'B' 両方）、"C*N"は文字CをN ms
+
+extern void PCINT1_vect(void);
+
+static const char *const ev_name[EV_NUM] = {"S1", "S2", "S2_LONG", "COMBO", "REP"};
+
+// 波形を流してイベント列（"S1 REP REP S2_LONG"のような空白区切り）を返す
+static const char *replay(const char *trace, uint16_t lock_at) {
+	static char out[1024];
+	uint16_t ms = 0;
+	uint8_t raw = 0;
+	const char *p = trace;
+
+	out[0] = 0;
+	while (*p) {
+		char c;
+		uint16_t n = 1, k;
+		if (*p == ' ') {
+			p++;
+			continue;
+		}
+		if (p[1] == '*') {
+			c = *p;
+			n = (uint16_t)strtoul(p + 2, (char **)&p, 10);
+		} else {
+			c = *p++;
+		}
+		for (k = 0; k < n; k++) {
+			uint8_t sw = c == '1' ? IN_S1 : c == '2' ? IN_S2 : c == 'B' ? (IN_S1 | IN_S2) : 0;
+			sim_switch(sw);
+			if (sw != raw && !input_active) PCINT1_vect();
+			raw = sw;
+			if (++ms == lock_at) input_lock(); // モード遷移（メインループ）
+			timer_tick();
+			if (!input_active) continue;
+			uint8_t ev = input_tick();
+			for (uint8_t e = 0; e < EV_NUM; e++) {
+				if (ev & EV_BIT(e)) {
+					if (out[0]) strcat(out, " ");
+					strcat(out, ev_name[e]);
+				}
+			}
+		}
+	}
+	return out;
+}
+
+#define REPLAY(trace, want) do { \
+	const char *got_ = replay(trace, 0); \
+	test_checks++; \
+	if (strcmp(got_, want)) { \
+		test_fails++; \
+		fprintf(stderr, "%s:%d: events \"%s\", expected \"%s\"\n", __FILE__, __LINE__, got_, want); \
+	} \
+} while (0)
+
+// 押下・解放のチャタリング（押した直後と離した直後に1?3msの跳ね返り）
+#define BOUNCE_S1_ON  "1.1..11.1"
+#define BOUNCE_S1_OFF ".1..1.1.."
+#define BOUNCE_S2_ON  "2..2.22.2"
+#define BOUNCE_S2_OFF "..2.2..2."
+
+static void test_short(void) {
+	REPLAY(".*20 " BOUNCE_S1_ON " 1*80 " BOUNCE_S1_OFF " .*50", "S1");
+	REPLAY(".*20 " BOUNCE_S2_ON " 2*150 " BOUNCE_S2_OFF " .*50", "S2");
+	// 3ms以下の跳ね返りだけでは確定しない（ノイズ）
+	REPLAY(".*10 1 .*5 11 .*5 111 .*5 2.2.2.2 .*20 B.B.B .*20", "");
+	// 跳ね返りが収まった後、4ms連続で確定
+	REPLAY("1*4 .*30", "S1");
+	REPLAY("1*3 .*30", "");
+}
+
+static void test_long(void) {
+	// S2長押し：0.6秒後から10Hzでリピート、2秒で長押し、解放イベントは出ない
+	REPLAY(".*5 " BOUNCE_S2_ON " 2*2500 " BOUNCE_S2_OFF " .*50",
+		"REP REP REP REP REP REP REP REP REP REP REP REP REP REP S2_LONG REP REP REP REP REP REP");
+	// リピートが始まった後の解放は短押しとしても通知される（設定値の最後の+1）
+	REPLAY(".*5 " BOUNCE_S2_ON " 2*750 " BOUNCE_S2_OFF " .*50", "REP REP S2");
+	// S1は長押し・リピートなし
+	REPLAY(".*5 " BOUNCE_S1_ON " 1*3000 " BOUNCE_S1_OFF " .*50", "S1");
+}
+
+static void test_combo(void) {
+	// S1を押してからS2（ずれ80ms）、2秒で同時押し、解放はばらばらでも単独押しにならない
+	REPLAY(".*5 " BOUNCE_S1_ON " 1*80 BB.B*3 B*2100 2*40 " BOUNCE_S2_OFF " .*50", "COMBO");
+	// 2秒未満の同時押しは何も出さない
+	REPLAY(".*5 " BOUNCE_S2_ON " 2*30 B*500 1*30 " BOUNCE_S1_OFF " .*50", "");
+	// S2長押し中にS1を足すと長押し判定をやり直し、同時押しの2秒で通知
+	REPLAY(".*5 2*1000 B*2100 .*50", "REP REP REP REP REP COMBO");
+}
+
+static void test_lock(void) {
+	const char *got;
+
+	// 長押しでのモード遷移直後のロック：押したままのS2は解放までリピートも解放も出さない
+	got = replay(".*5 2*3000 .*50", 2010);
+	test_checks++;
+	if (strcmp(got, "REP REP REP REP REP REP REP REP REP REP REP REP REP REP S2_LONG REP")) {
+		test_fails++;
+		fprintf(stderr, "%s:%d: events \"%s\"\n", __FILE__, __LINE__, got);
+	}
+	// 解放後は通常どおり
+	REPLAY(".*5 1*100 .*50", "S1");
+}
+
+// 全解放で安定したらサンプリングを止める（次はピン変化割込みで再開）
+static void test_idle(void) {
+	replay(".*5 1*100 .*3", 0);
+	CHECK_EQ(input_active, 1);
+	replay(".*5", 0);
+	CHECK_EQ(input_active, 0);
+	// 停止中の押下も取りこぼさない
+	REPLAY(".*20 1*6 .*20", "S1");
+	CHECK_EQ(input_active, 0);
+}
+
+int main(void) {
+	input_init();
+	test_short();
+	test_long();
+	test_combo();
+	test_lock();
+	test_idle();
+	return test_done("test_input");
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "test.h"
+
+// 設定の保存（EE_READY割込みによる書き込み）を任意のバイトで電源断し、再起動後のsettings_loadが
+// 直前に保存できた設定か新しい設定のどちらか（途中の混ざったものや既定値ではない）を返すことを確認する
+// 再起動でstatic変数を初期値に戻すため、settings.cはここで取り込む
+
+#include "settings.c"
+
+static uint32_t rnd = 2463534242u;
+
+static uint32_t xorshift(void) {
+	rnd ^= rnd << 13;
+	rnd ^= rnd >> 17;
+	rnd ^= rnd << 5;
+	return rnd;
+}
+
+// 書き込みの完了を待つ（電源断の後もファームウェアはレコードの最後まで書き込みを続ける）
+static void settle(void) {
+	do {
+		sim_run(5 * SIM_MS);
+	} while (settings_busy() || (EECR & (1 << EEPE)));
+}
+
+// 電源を入れ直す：レジスタと.bss/.dataを初期値に戻してsettings_load
+static uint8_t reboot(settings_t *s) {
+	settle();
+	EECR = 0;
+	memset(rec, 0, sizeof(rec));
+	slot = 0;
+	wr_idx = SET_REC_LEN;
+	sim_ee_power_cut(0, 0);
+	return settings_load(s);
+}
+
+static void random_settings(settings_t *s) {
+	uint8_t *d = (uint8_t *)s;
+	for (uint8_t i = 0; i < SET_DATA_LEN; i++) d[i] = (uint8_t)xorshift();
+}
+
+// 消去（全1）と書き込み（0を書く）の途中の値
+static uint8_t partial(uint8_t old, uint8_t val) {
+	switch (xorshift() % 4) {
+		case 0:  return old;                              // 始まる前
+		case 1:  return 0xFF;                             // 消去だけ終わった
+		case 2:  return (uint8_t)(val | xorshift());      // 書き込みの途中
+		default: return (uint8_t)(old | xorshift());      // 消去の途中
+	}
+}
+
+// 未使用のEEPROM（全0xFF）は既定値、保存・再起動で同じ値
+static void test_basic(void) {
+	settings_t s, t;
+
+	CHECK_EQ(reboot(&s), 0);
+	CHECK_EQ(s.flags, SET_24H);
+	CHECK_EQ(s.dim, 0x50);
+
+	s.flags = 0;
+	s.alarm[2][0] = SET_AL_EN | 0x07;
+	s.alarm[2][1] = 0x30;
+	uint32_t w = sim_ee_writes;
+	CHECK_EQ(settings_save(&s), 1);
+	CHECK_EQ(settings_save(&s), 0); // 書き込み中
+	settle();
+	CHECK(sim_ee_writes - w <= SET_REC_LEN);
+	CHECK_EQ(reboot(&t), 1);
+	CHECK(!memcmp(&s, &t, sizeof(s)));
+
+	// 同じ内容は書かない
+	w = sim_ee_writes;
+	CHECK_EQ(settings_save(&t), 1);
+	settle();
+	CHECK_EQ(sim_ee_writes, w);
+}
+
+// 保存をランダムな書き込みで電源断（リングと8bitの連番が何周もする回数）
+static void test_power_cut(void) {
+	settings_t ok, next, got;
+	uint32_t cuts = 0, kept = 0, fail_old = 0, fail_mix = 0;
+
+	random_settings(&ok);
+	settings_save(&ok);
+	settle();
+	for (uint16_t n = 0; n < 3000; n++) {
+		random_settings(&next);
+		// first回目の書き込みで電源断（SET_REC_LEN以上は電源断なし、同じ値のバイトは書かないので書き込みは最大16回）
+		// そのセルの値は書き込みの順（レコードの先頭から、同じ値を飛ばす）で求める
+		uint8_t first = 1 + xorshift() % (SET_REC_LEN + 2);
+		uint16_t base = rec_adr((slot + 1) % SET_SLOTS, 0);
+		uint8_t r[SET_REC_LEN];
+		memcpy(r, &next, SET_DATA_LEN);
+		r[REC_SEQ] = (uint8_t)(rec[REC_SEQ] + 1);
+		r[REC_CRC] = rec_crc(r);
+		sim_ee_power_cut(0, 0);
+		for (uint8_t i = 0, k = 0; i < SET_REC_LEN; i++) {
+			if (sim_eeprom[base + i] != r[i] && ++k == first) {
+				sim_ee_power_cut(first, partial(sim_eeprom[base + i], r[i]));
+				break;
+			}
+		}
+		CHECK_EQ(settings_save(&next), 1);
+		settle();
+		uint8_t lost = sim_ee_lost;
+		CHECK_EQ(reboot(&got), 1);
+		if (!memcmp(&got, &next, sizeof(got))) {
+			ok = next;
+			kept++;
+		} else if (!memcmp(&got, &ok, sizeof(got))) {
+			if (!lost) fail_old++; // 電源断なしで古い設定
+		} else {
+			fail_mix++;
+		}
+		cuts += lost;
+	}
+	CHECK_EQ(fail_old, 0);
+	CHECK_EQ(fail_mix, 0);
+	CHECK(cuts > 2000);
+	CHECK(kept > 300);
+
+	// 電源断の後も保存は続けられる
+	random_settings(&next);
+	settings_save(&next);
+	settle();
+	CHECK_EQ(reboot(&got), 1);
+	CHECK(!memcmp(&got, &next, sizeof(got)));
+}
+
+int main(void) {
+	sei();
+	test_basic();
+	test_power_cut();
+	return test_done("test_settings");
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <math.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "config.h"
+#include "stopwatch.h"
+#include "sim.h"
+#include "test.h"
+
+// ストップウォッチ（sw_int0/sw_tick/sw_get）：RTCの1Hz（INT0）に対してTimer1（内部RC）が速い・遅い場合の精度、
+// 読み出しが戻らないこと、開始・停止の積算を確認する
+// INT0はここで作る1Hzの立ち下がり（sim_cfg.rtc_ppmの周期）、時間の正解はシミュレーション時間
+
+static sim_time_t int0_next;
+static uint32_t redraws;
+
+ISR(INT0_vect) {
+	sw_int0();
+}
+
+ISR(TIMER1_COMPA_vect) {
+	if (sw_tick()) redraws++;
+}
+
+static sim_time_t rtc_period(void) {
+	return (sim_time_t)(SIM_SEC / (1.0 + sim_cfg.rtc_ppm * 1e-6));
+}
+
+// RTCの/INT：1秒ごとに立ち下がり（LOWは7.8ms）
+static void int0_fall(void);
+static void int0_rise(void) {
+	sim_int_line(1);
+}
+static void int0_fall(void) {
+	sim_int_line(0);
+	sim_at(sim_now + 7800 * SIM_US, int0_rise);
+	int0_next += rtc_period();
+	sim_at(int0_next, int0_fall);
+}
+
+static double sw_sec(void) {
+	sw_time_t t;
+	sw_get(&t);
+	CHECK(t.ms < 1000);
+	return t.sec + t.ms / 1000.0;
+}
+
+static double now_sec(void) {
+	return sim_now / (double)SIM_SEC;
+}
+
+// 補間の誤差の上限：開始と読み出しのそれぞれで、1秒内のRCの誤差と1ms刻み
+static double bound(void) {
+	return 2 * (fabs(sim_cfg.cpu_ppm) * 1e-6 + 0.001) + 1e-6;
+}
+
+// RCの誤差（±3%まで）に対して、長時間でも誤差は補間分のみ（RTCの誤差はそのまま）
+static void test_accuracy(void) {
+	static const double ppm[] = {0, -2000, 2000, -30000, 30000};
+	static const double rtc[] = {0, 50, -50, 0, 0};
+
+	for (uint8_t k = 0; k < sizeof(ppm) / sizeof(ppm[0]); k++) {
+		sim_cfg.cpu_ppm = ppm[k];
+		sim_cfg.rtc_ppm = rtc[k];
+		sw_reset();
+		sim_run((sim_time_t)(rand() % 1000) * SIM_MS + 137 * SIM_US); // INT0に対する開始の位相
+		double t0 = now_sec();
+		sw_start();
+		for (uint32_t s = 1; s <= 3600; s += s < 10 ? 1 : 599) {
+			sim_run((sim_time_t)((t0 + s + (rand() % 1000) / 1000.0) * SIM_SEC) - sim_now);
+			double real = (now_sec() - t0) * (1 + rtc[k] * 1e-6);
+			double err = sw_sec() - real;
+			if (fabs(err) > bound()) fprintf(stderr, "  cpu %+.0f ppm rtc %+.0f ppm: %.3f s after %.3f s\n", ppm[k], rtc[k], err, real);
+			CHECK(fabs(err) <= bound());
+		}
+		// 再描画要求は10msごと（Timer1基準）
+		redraws = 0;
+		sim_run(SIM_SEC);
+		CHECK(fabs(redraws - 100 * (1 + ppm[k] * 1e-6)) <= 1);
+		sw_stop();
+	}
+	sim_cfg.cpu_ppm = 0;
+	sim_cfg.rtc_ppm = 0;
+}
+
+// 1msごとの読み出しが戻らない（RCが速いと補間は999msで止まり、遅いとINT0で進む）
+static void test_monotonic(void) {
+	static const double ppm[] = {-30000, 30000};
+
+	for (uint8_t k = 0; k < 2; k++) {
+		sim_cfg.cpu_ppm = ppm[k];
+		uint32_t back = 0;
+		double last = 0, step = 0;
+		sw_reset();
+		sw_start();
+		for (uint16_t n = 0; n < 5000; n++) {
+			sim_run(SIM_MS);
+			double v = sw_sec();
+			if (v < last) back++;
+			if (v - last > step) step = v - last;
+			last = v;
+		}
+		CHECK_EQ(back, 0);
+		CHECK(step < 0.001 + 2 * fabs(ppm[k]) * 1e-6); // 飛びはINT0で揃うときのみ
+		sw_stop();
+	}
+	sim_cfg.cpu_ppm = 0;
+}
+
+// 開始・停止を繰り返しても動作区間の合計（停止中は進まない）、ゼロに戻す
+static void test_start_stop(void) {
+	double total = 0;
+
+	sim_cfg.cpu_ppm = -10000;
+	sw_reset();
+	CHECK_EQ(sw_running(), 0);
+	CHECK(sw_sec() == 0);
+	for (uint8_t n = 0; n < 50; n++) {
+		double t0 = now_sec();
+		sw_start();
+		CHECK_EQ(sw_running(), 1);
+		sim_run((sim_time_t)(rand() % 5000 + 1) * SIM_MS + (rand() % 1000) * SIM_US);
+		sw_stop();
+		total += now_sec() - t0;
+		double v = sw_sec();
+		CHECK(fabs(v - total) <= (n + 1) * bound());
+		sim_run((sim_time_t)(rand() % 3000 + 1) * SIM_MS);
+		CHECK(sw_sec() == v); // 停止中
+	}
+	redraws = 0;
+	sim_run(SIM_SEC);
+	CHECK_EQ(redraws, 0);
+	sw_reset();
+	CHECK(sw_sec() == 0);
+	sim_cfg.cpu_ppm = 0;
+}
+
+int main(void) {
+	srand(1);
+	TCCR1B = (1 << WGM12) | T1_CS;
+	OCR1A = T1_OCR;
+	TIMSK1 = (1 << OCIE1A);
+	EICRA = (1 << ISC01);
+	EIMSK = (1 << INT0);
+	int0_next = 500 * SIM_MS;
+	sim_at(int0_next, int0_fall);
+	sei();
+	sim_run(2 * SIM_SEC);
+
+	test_accuracy();
+	test_monotonic();
+	test_start_stop();
+	return test_done("test_stopwatch");
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include "timer.h"
+#include "test.h"
+
+// timer.cの差分リストを、満了時刻を直接持つモデルと乱数操作で比べる
+//   順序：同じティックの満了は登録順（開始・周期の再登録の順）
+//   停止：停止したタイマーは満了しない（コールバック内から別のタイマーを止める場合を含む）
+//   周期：満了時刻基準で再登録され、他のタイマーの操作があってもずれない
+
+#define N      12
+#define PROBE  (N - 1)   // 乱数操作しない周期タイマー（ずれの確認）
+#define PROBE_MS 997
+#define TICKS  400000UL
+
+static swtimer_t tm[N];
+static struct {
+	uint8_t active;
+	uint16_t period;
+	uint32_t due, seq;   // 満了ティック、登録順
+} m[N];
+static uint32_t now, seqno, rnd = 1;
+static uint8_t fired[4 * N], nfired;
+
+static uint32_t xorshift(void) {
+	rnd ^= rnd << 13;
+	rnd ^= rnd >> 17;
+	rnd ^= rnd << 5;
+	return rnd;
+}
+
+static void m_start(uint8_t k, uint16_t ms, uint16_t period) {
+	m[k].active = 1;
+	m[k].due = now + (ms ? ms : 1);
+	m[k].period = period;
+	m[k].seq = ++seqno;
+}
+
+// コールバック内の操作（実装とモデルに同じ操作をする）
+static void action(uint8_t k, uint8_t real) {
+	uint8_t j;
+	uint16_t ms;
+
+	if (k == PROBE) return;
+	switch (k % 3) {
+		case 0: // 次のタイマーを止める
+			j = (uint8_t)((k + 1) % PROBE);
+			if (real) timer_stop(&tm[j]);
+			else m[j].active = 0;
+			break;
+		case 1: // 別のタイマーをワンショットで開始
+			j = (uint8_t)((k + 2) % PROBE);
+			ms = (uint16_t)(1 + (k * 7 + now) % 50);
+			if (real) timer_start(&tm[j], ms, 0);
+			else m_start(j, ms, 0);
+			break;
+	}
+}
+
+#define CB(k) static void cb##k(void) { fired[nfired++] = k; action(k, 1); }
+CB(0) CB(1) CB(2) CB(3) CB(4) CB(5) CB(6) CB(7) CB(8) CB(9) CB(10) CB(11)
+static void (*const cbs[N])(void) = {cb0, cb1, cb2, cb3, cb4, cb5, cb6, cb7, cb8, cb9, cb10, cb11};
+
+// モデルの1ティック（nowは進めた後）：満了したものを登録順に（周期は再登録してからコールバック）
+static uint8_t model_tick(uint8_t *out) {
+	uint8_t n = 0;
+
+	for (;;) {
+		int k = -1;
+		for (uint8_t i = 0; i < N; i++) {
+			if (m[i].active && m[i].due == now && (k < 0 || m[i].seq < m[k].seq)) k = i;
+		}
+		if (k < 0) return n;
+		out[n++] = (uint8_t)k;
+		if (m[k].period) {
+			m[k].due = now + m[k].period;
+			m[k].seq = ++seqno;
+		} else {
+			m[k].active = 0;
+		}
+		action((uint8_t)k, 0);
+	}
+}
+
+static void run(uint32_t seed) {
+	uint8_t want[4 * N], nwant;
+	uint32_t probe = 0, bad = 0, t0 = now;
+
+	rnd = seed;
+	for (uint8_t i = 0; i < N; i++) {
+		timer_stop(&tm[i]);
+		tm[i] = (swtimer_t)SWTIMER(cbs[i]);
+		m[i].active = 0;
+	}
+	timer_start(&tm[PROBE], PROBE_MS, PROBE_MS);
+	m_start(PROBE, PROBE_MS, PROBE_MS);
+
+	for (uint32_t n = 0; n < TICKS && bad < 5; n++) {
+		// メインからの操作（開始・再開始・停止）
+		uint32_t r = xorshift();
+		if (r % 4 == 0) {
+			uint8_t k = (uint8_t)((r >> 8) % PROBE);
+			uint16_t ms = (uint16_t)((r >> 16) % 300);
+			uint16_t period = (r & 0x100) ? (uint16_t)(1 + (r >> 24) % 100) : 0;
+			if ((r >> 4) % 4 == 0) {
+				timer_stop(&tm[k]);
+				m[k].active = 0;
+			} else {
+				timer_start(&tm[k], ms, period);
+				m_start(k, ms, period);
+			}
+		}
+
+		nfired = 0;
+		now++;
+		timer_tick();
+		nwant = model_tick(want);
+		uint8_t ok = (nfired == nwant);
+		for (uint8_t i = 0; ok && i < nwant; i++) ok = (fired[i] == want[i]);
+		for (uint8_t i = 0; ok && i < N; i++) ok = (timer_active(&tm[i]) == m[i].active);
+		if (!ok) {
+			fprintf(stderr, "  seed %u tick %u: fired", seed, now);
+			for (uint8_t i = 0; i < nfired; i++) fprintf(stderr, " %u", fired[i]);
+			fprintf(stderr, ", expected");
+			for (uint8_t i = 0; i < nwant; i++) fprintf(stderr, " %u", want[i]);
+			fprintf(stderr, "\n");
+			bad++;
+		}
+		for (uint8_t i = 0; i < nfired; i++) {
+			if (fired[i] == PROBE) {
+				probe++;
+				if ((now - t0) % PROBE_MS) bad++;
+			}
+		}
+	}
+	CHECK_EQ(bad, 0);
+	CHECK_EQ(probe, TICKS / PROBE_MS); // 周期タイマーはずれずに満了し続ける
+}
+
+int main(void) {
+	static const uint32_t seeds[] = {1, 2463534242UL, 88172645UL, 12345};
+	for (uint8_t i = 0; i < sizeof(seeds) / sizeof(seeds[0]); i++) run(seeds[i]);
+	return test_done("test_timer");
+}
\ No newline at end of file